@@ -1,11 +1,22 @@
+#ifdef G4MULTITHREADED
+#include "G4MTRunManager.hh"
+#include "TROOT.h"
+#else
 #include "G4RunManager.hh"
+#endif
 #include "G4UImanager.hh"
+#include "G4Version.hh"
+#include "Randomize.hh"
 #include "TrackerSD.hh"
 #include "DetectorConstruction.hh"
 #include "PhysicsList.hh"
+#if G4VERSION_NUMBER>=1000
+#include "ActionInitialization.hh"
+#else
 #include "PrimaryGeneratorAction.hh"
 #include "RunAction.hh"
 #include "EventAction.hh"
+#endif
 #include "InputManager.hh"
 #include "CascadeGenerator.hh"
 #include "DAQManager.hh"
@@ -20,6 +31,7 @@
 #include "G4UIExecutive.hh"
 #endif
 
+#include <ctime>
 #include <iostream>
 using std::cout;
 using std::cin;
@@ -48,8 +60,18 @@ int main (int argc,char** argv) {
   CascadeGenerator* CasGen = new CascadeGenerator(InMgr);
   DAQManager* DAQMgr = new DAQManager(InMgr, CasGen);
 
+  CLHEP::HepRandom::setTheSeed(time(0));//workers are seeded from the master engine
+
 //  construct the default run manager
+  #ifdef G4MULTITHREADED
+  int N_threads;
+  InMgr->GetVariable("N_threads",N_threads);
+  ROOT::EnableThreadSafety();//trees are filled from several threads
+  G4MTRunManager* runManager = new G4MTRunManager;
+  runManager->SetNumberOfThreads(N_threads);
+  #else
   G4RunManager* runManager = new G4RunManager;
+  #endif
 
 //  Instantiation and initialization of the Visualization Manager
   #ifdef G4VIS_USE
@@ -65,20 +87,18 @@ int main (int argc,char** argv) {
   runManager->SetUserInitialization(new PhysicsList);
 //  runManager->SetUserInitialization(physics);
 
-//  set mandatory user action class
+//  set mandatory user action class (built per worker thread, before the SD)
+  #if G4VERSION_NUMBER>=1000
+  runManager->SetUserInitialization(new ActionInitialization(CasGen,DAQMgr));
+  #else
+  runManager->SetUserAction(new PrimaryGeneratorAction(CasGen));//Geant4 9.x: sequential, the SD is set up in Construct
+  runManager->SetUserAction(new RunAction(CasGen,DAQMgr));
+  runManager->SetUserAction(new EventAction(DAQMgr));
+  #endif
 
 //  initialize G4 kernel
   runManager->Initialize();
 
-  G4VUserPrimaryGeneratorAction* gen_action = new PrimaryGeneratorAction(CasGen);
-  runManager->SetUserAction(gen_action);
-
-  G4UserRunAction* run_action = new RunAction(CasGen,DAQMgr);  
-  runManager->SetUserAction(run_action);
-
-  G4UserEventAction* event_action = new EventAction(DAQMgr);
-  runManager->SetUserAction(event_action);
-
 // Get the pointer to the User Interface manager
   G4UImanager* UImanager = G4UImanager::GetUIpointer();
 
@@ -93,9 +113,9 @@ int main (int argc,char** argv) {
   char beamOn[30];
   int N_events;
   InMgr->GetVariable("N_events",N_events);
-  sprintf(beamOn,"/run/beamOn %i", N_events);
 
   for (bool end=false; end!=true; end=CasGen->GetEnd()) {
+    sprintf(beamOn,"/run/beamOn %i", N_events*CasGen->GetSweepSize());//N_events per cascade
     UImanager->ApplyCommand(beamOn);
   }
 
@@ -1,3 +1,15 @@
 #!/bin/bash
 
 g++ -O3 $(root-config --cflags --libs) analysis.C -o analysis
+g++ -O3 -Iinclude $(root-config --cflags --libs) fold.C src/InputManager.cc src/CascadeEnumerator.cc src/Digitiser.cc src/Addback.cc src/EventPool.cc src/ResponseFold.cc -o fold
+g++ -O3 -Iinclude $(root-config --cflags --libs) digitise.C src/InputManager.cc src/Digitiser.cc src/Addback.cc -o digitise
+g++ -O3 -std=c++11 -pthread -Iinclude $(root-config --cflags --libs) analyse.C src/InputManager.cc src/Digitiser.cc src/Addback.cc src/Likelihood.cc src/ExpData.cc -o analyse
+g++ -O3 -Iinclude $(root-config --cflags --libs) convolve.C src/InputManager.cc src/Digitiser.cc src/Addback.cc src/Convolution.cc -o convolve
+g++ -O3 -Iinclude $(root-config --cflags --libs) thresholds.C src/ThresholdTable.cc -o thresholds
+g++ -O3 -Iinclude expdata.C src/ExpData.cc -o expdata
+g++ -O3 -std=c++11 -pthread -Iinclude $(root-config --cflags --libs) mixture.C src/ExpData.cc src/ThresholdTable.cc src/MixtureFit.cc -o mixture
+g++ -O3 -std=c++11 -Iinclude $(root-config --cflags --libs) sparsefit.C src/ExpData.cc src/Likelihood.cc src/SparseMatrix.cc src/SparseTemplates.cc -o sparsefit
+g++ -O3 -std=c++11 -Iinclude $(root-config --cflags --libs) packlib.C src/TemplateLibrary.cc -o packlib
+g++ -O3 -std=c++11 -Iinclude $(root-config --cflags --libs) catalog.C -lsqlite3 -o catalog
+g++ -O3 -std=c++11 -pthread -Iinclude $(root-config --cflags --libs) merge.C src/InputManager.cc src/Digitiser.cc src/Addback.cc -o merge
+g++ -O3 -Iinclude $(root-config --cflags --libs) columns.C src/EventColumns.cc -lz -o columns
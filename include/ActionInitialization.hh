@@ -0,0 +1,31 @@
+#ifndef ActionInitialization_h
+#define ActionInitialization_h 1
+
+#include "G4Version.hh"
+
+#if G4VERSION_NUMBER>=1000 //Geant4 9.x sets the actions directly in BGO.cc
+
+#include "G4VUserActionInitialization.hh"
+#include "CascadeGenerator.hh"
+#include "DAQManager.hh"
+
+class ActionInitialization : public G4VUserActionInitialization {
+
+  public:
+
+  ActionInitialization(CascadeGenerator* CasGen, DAQManager* DAQMgr);
+ ~ActionInitialization();
+
+  void BuildForMaster() const;
+  void Build() const;
+
+  private:
+
+  CascadeGenerator* CasGen;
+  DAQManager* DAQMgr;//master instance, owns the output file
+
+};
+
+#endif
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef Addback_h
+#define Addback_h 1
+
+#include <vector>
+#include <Rtypes.h>
+#include "TFile.h"
+
+const int max_neighbour = 31;//crystal copy numbers 0-30, one bit each
+
+//Crystal neighbour table of the array and the addback clustering built on
+//it. DetectorConstruction registers the centre of every placed crystal
+//case, Build() turns them into one 32-bit neighbour mask per copy number
+//(centres closer than addback_dist). Cluster() then merges the fired
+//crystals of an event into connected clusters with bit operations only,
+//so it is cheap enough for every event. The masks are written to the
+//output ("Neighbours" tree) and read back by the offline tools.
+//Static: the array exists once per process and is set before any run.
+
+class Addback {
+
+  public:
+
+  static void SetPosition(int det, double x, double y, double z);//case centre, cm
+  static void Build(double dist);//neighbours = centres closer than dist cm
+  static UInt_t GetMask(int det) {return mask[det];};
+  static bool IsBuilt() {return built;};
+
+  static void Write();//"Neighbours" tree in the current directory
+  static bool Read(TFile* f);//false = no table in f
+
+  static void Cluster(const std::vector<double>& E, const std::vector<int>& det, std::vector<double>& E_cluster);
+
+  private:
+
+  static double pos[max_neighbour][3];
+  static bool placed[max_neighbour];
+  static UInt_t mask[max_neighbour];
+  static bool built;
+
+};
+
+#endif
@@ -0,0 +1,39 @@
+#ifndef CascadeEnumerator_h
+#define CascadeEnumerator_h 1
+
+#include <vector>
+
+//Enumerates the "Regular" cascades of an excited state without storing them.
+//A cascade is n_gamma energy steps e_0<=e_1<=...<=e_(n_gamma-1) (in units of
+//dE=E_x/n_step, zero = no gamma) summing to n_step, i.e. a partition of n_step
+//into at most n_gamma parts. Cascades are ranked in the lexicographic order of
+//the original nested-loop generator, so rank k is the cascade of run k.
+
+class CascadeEnumerator {
+
+  public:
+
+  CascadeEnumerator(int n_gamma, int n_step);
+ ~CascadeEnumerator();
+
+  long long Count() {return Partitions(n_step,n_gamma);};//no. of valid cascades
+  void Unrank(long long k, std::vector<int>& step);//k-th cascade
+  long long Rank(const std::vector<int>& step);//inverse of Unrank
+  bool Next(std::vector<int>& step);//steps to the cascade of rank+1, false at the end
+
+  int GetNGamma() {return n_gamma;};
+  int GetNStep() {return n_step;};
+
+  private:
+
+  long long Partitions(int s, int k);//partitions of s into at most k parts
+  long long Completions(int s, int k, int v);//cascade tails of k steps >=v summing to s
+
+  int n_gamma;
+  int n_step;
+
+  std::vector<long long> table;//Partitions(s,k) at s*(n_gamma+1)+k
+
+};
+
+#endif
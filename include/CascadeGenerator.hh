@@ -12,6 +12,9 @@
 #include <vector>
 #include "G4UImanager.hh"
 #include "InputManager.hh"
+#include "CascadeEnumerator.hh"
+
+const int max_gamma = 10;//size of the cascade array in the Run tree
 
 class CascadeGenerator {
 
@@ -21,32 +24,42 @@ class CascadeGenerator {
  ~CascadeGenerator();
   void GenerateCascade();
   bool GenerateCascadeCustom();
+  void GenerateCascadeList();
+  void GenerateCascadeLibrary();
   std::vector<double> GetCascade();
+  const std::vector<double>& GetCascade(int index);//index-th cascade of this run
+  int GetCascadeIndex(int eventID);//cascade an event belongs to
+  int GetNCascades() {return n_cascade;};//cascades in this run
+  int GetSweepSize();//cascades in the next run
   void SetCascade();
   bool GetEnd() {return end;};
-  void EndOfRun() {N_run++;};
+  void EndOfRun();
   int GetRun() {return N_run;};
   double GetGammaE();
 
   private:
 
   InputManager* InMgr;
+  CascadeEnumerator* CasEnum;//"Regular" cascades, generated on demand
 
-  std::vector<double> E_array;//energy array
-  std::vector<double> gamma_array;//temp cascade array
-  std::vector<double> gammatot_array;//total cascade array
-  std::vector<double>::iterator it;
-  std::vector<int> point_array;//permitation of cascade
+  std::vector<double> gammatot_array;//custom cascade
+  std::vector<int> step;//current cascade in units of dE
 
   std::vector<double> cascade;//energy array for specific cascade
+  std::vector< std::vector<double> > sweep;//cascades of this run, sweep mode
+  std::vector< std::vector<double> > list;//distinct "List" cascades, canonical order, or "Library" grid
 
   int n_gamma;//no. of gammas
   int n_bin;//no. of energy bins
 
-  int count;//no. of permitation
-
   int N_run;//run number
   int run_end;//last run number
+  int first_run;//run number of the first cascade (0 Regular, 1 List/Library)
+  long long n_total;//no. of cascades available
+
+  int N_events;//events per cascade
+  int cascades_per_run;//>1 runs several cascades in one Geant4 run
+  int n_cascade;//cascades in the current run
 
   double E_x;//energy of excited state
   double dE;
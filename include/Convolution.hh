@@ -0,0 +1,35 @@
+#ifndef Convolution_h
+#define Convolution_h 1
+
+#include <vector>
+#include "Digitiser.hh"
+
+//Detector response convolution of a binned spectrum. The Gaussian response
+//of every source bin (width from the Digitiser resolution at the bin
+//centre) is integrated over the output bins once per binning and kept as a
+//band of +-n_sigma; applying it is then O(n_bin*band) instead of the
+//O(n_bin^2) exp() calls per output bin of the old DAQManager::gaus. Counts
+//are conserved apart from what the response moves outside the range.
+
+class Convolution {
+
+  public:
+
+  Convolution(int n_bin, double min, double max, Digitiser& D, double n_sigma=5.);
+ ~Convolution();
+
+  void Apply(const double* in, double* out);//n_bin values each
+  void Batch(const double* in, double* out, int n_spectrum);//spectrum s at s*n_bin
+
+  int GetNBins() {return n_bin;};
+
+  private:
+
+  int n_bin;
+  std::vector<int> lo;//first output bin of source bin j
+  std::vector<int> offset;//weights of source bin j from offset[j] to offset[j+1]-1
+  std::vector<double> weight;
+
+};
+
+#endif
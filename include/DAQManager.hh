@@ -11,6 +11,14 @@
 #include "TFile.h"
 #include "InputManager.hh"
 #include "CascadeGenerator.hh"
+#include "Digitiser.hh"
+#include "EventWriter.hh"
+#include "RunSegments.hh"
+#include "DigiPipeline.hh"
+#include "Histogram.hh"
+#include "SparseMatrix.hh"
+#include "Convolution.hh"
+#include "TRandom3.h"
 #include <TTree.h>
 #include <TBranch.h>
 
@@ -19,9 +27,10 @@ class DAQManager {
   public:
 
   DAQManager(InputManager* InMgr, CascadeGenerator* CasGen);
+  DAQManager(DAQManager* master);//worker thread instance, merges into master
  ~DAQManager();
 
-  void StartOfEvent();
+  void StartOfEvent(int eventID);
   void EndOfEvent();
 
   void StartOfRun();
@@ -29,49 +38,136 @@ class DAQManager {
 
   void SetGammaE(double E);
   void SetDetNum(int n);
-  void Write();
+  std::vector<TH1*> Write();//this run's histograms as ROOT ones, for the file
   void MultLikelihood();
   void EtotLikelihood();
-  float gaus(float energy[200], float counts[200], int j);
 
   private:
 
-  struct Data_Event {
-    Float_t sum;
-    Float_t esort[10];
-    Float_t ecal[30];
-    Int_t Mult;
-  };
+  void Book(int n_cascade);
+  void Process(int event_index, const Raw_Event& deposit);
+  void OpenFile(const char* FileName, bool sweep);
+  void CloseFile();
+  bool Digitise(Digitiser& D, Data_Event& event, Histogram* h_E, Histogram* h_Etot, Histogram* h_mult);
+  void FillEvent();
+  void FlushEvents();
+  void MergeRun();
+  void WriteSparse();
 
   struct Data_Run {
     Int_t Event;
     Int_t Run;
-    Float_t cascade[5];
+    Float_t cascade[max_gamma];
+  };
+
+  struct Index_Run {//RunIndex row: where the events of a run are
+    Int_t Run;
+    Int_t Shard;//file number, OutputMode "Shard"
+    Long64_t First;//first Event tree entry of a stretch of the run
+    Long64_t Entries;//Event tree entries of the stretch
+  };
+
+  struct Data_Sparse {//Sparse row: one CSR matrix of a cascade
+    Int_t Run;
+    Int_t Matrix;//0 = E0 vs E1 (Mult>1), 1 = gamma-gamma pairs, higher energy = row
+    Int_t Rows;//row_ptr entries, rows+1
+    Int_t nnz;
+  };
+
+  struct Buffered {//worker event waiting for the master tree
+    Data_Event data;
+    Int_t run;
+    Raw_Event raw;//RawTree only
+  };
+
+  struct Accumulator {//results of one cascade, filled by all threads, reused run after run
+    Accumulator(int n_fanout, bool library, bool tables, bool addback, bool sparse);
+   ~Accumulator();
+    void Reset();
+    Histogram* h_E;//Gamma energy histo
+    Histogram* h_Etot;//Total energy histo
+    Histogram* h_mult;//Multiplicity histo
+    Histogram* h_cmult;//Addback: cluster multiplicity
+    Histogram* h_lib;//"Library": raw deposit per crystal
+    Histogram* h_libmult;//"Library": crystals fired per gamma
+    Histogram* h_E0Mult;//ThresholdTables: E0 vs multiplicity
+    Histogram* h_E0E1;//ThresholdTables: E0 vs E1 (0 for one crystal)
+    SparseMatrix* s_E0E1;//SparseMatrices: merged from the threads at end of run
+    SparseMatrix* s_gg;
+    std::vector<Histogram*> f_E;//E_, Etot_ and Mult_ of each fan-out config
+    std::vector<Histogram*> f_Etot;
+    std::vector<Histogram*> f_mult;
+    int N_event;
+    int N_coinc;
+  };
+
+  struct Count {//events of one cascade seen by this thread
+    int N_event;
+    int N_coinc;
   };
 
   Data_Event data_event;
   Data_Run data_run;
+  Long64_t run_seed;//master engine seed of this Geant4 run, Seed branch of the Run tree
+  Int_t event_run;//cascade run number of the current event
+  Raw_Event raw_event;//unsmeared deposits of the current event
 
   TTree* EventTree;
   TTree* RunTree;
+  TTree* RawTree;//sparse unsmeared deposits per event, for digitise and EventPool
+  TTree* IndexTree;//RunIndex, consolidated output only
+  TTree* SparseTree;//SparseMatrices only
+  ColumnWriter* columns;//EventColumns: the Event tree rows again as a .col file, master only
   TBranch* EventBranch;
   TBranch* RunBranch;
   TFile* f1;
 
-//  std::vector<double> E_gamma;//energy of each gamma detected
+  string output;//OutputMode: "PerRun", "Single" or "Shard"
+  string OutputFile;//consolidated file name without .root
+  double shard_MB;//"Shard": a new file once this size is passed
+  int shard;
+  Index_Run index_run;
+  RunSegments segments;//master only, stretches of each run in the Event tree
+
+  DAQManager* master;//0 for the master (or sequential) instance
+  EventWriter* writer;//master only, 0 = trees filled on the simulation threads
+  DigiPipeline* pipeline;//master only, 0 = events digitised on the transport threads
+  std::vector<DAQManager*> stages;//master only, one instance per digitiser thread
+  std::vector<Buffered> event_buffer;
+  std::vector<Accumulator*> acc;//master only, the first n_acc are this run's cascades
+  int n_acc;
+  std::vector<Count> count;//per cascade of this run, added to acc at end of run
+  std::vector<SparseMatrix> s_E0E1;//per cascade of this run, this thread's, merged into acc
+  std::vector<SparseMatrix> s_gg;
+  Data_Sparse data_sparse;
+  std::vector<Int_t> row_ptr;//CSR of the matrix being written
+  std::vector<UShort_t> col;
+  std::vector<UInt_t> val;
+  int index;//cascade index of the current event
+
+  std::vector<double> E_gamma;//raw energy of each gamma detected
+  std::vector<int> N_det;//coresponding detector number
+  std::vector<double> E_digi;//after smearing, thresholds and dead crystals
+  std::vector<int> N_digi;
+  std::vector<double> E_sort;//E_digi in decending order
+
+  Digitiser* Digi;
+  std::vector<Digitiser> fanout;//extra DAQ configs, histograms only (DigiFile)
+  Data_Event fan_event;
+  TRandom3* rng;//smearing, one per thread
+  bool library;//single-gamma response library run
+  bool raw;//write the Raw tree
+  bool tables;//E0Mult_/E0E1_ threshold tables
+  bool sparse;//Sparse tree of E0-E1 and gamma-gamma matrices
+  int column_level;//EventColumns zlib level, -1 = no column file
   InputManager* InMgr;
   CascadeGenerator* CasGen;
-  double threshold;
   int N_coinc;
   int N_run;
   int N_event;
   int mult;//multiplicity of event
   double eff;
-
-  TH2F* h_E;//Gamma energy histo
-  TH1F* h_Etot;//Total energy histo
-  TH1F* h_Etotconv;//Total energy histo convoluted
-  TH1F* h_mult;//Multiplicity histo
+  Convolution* Conv;//EtotConv: Etot with the detector response folded in
 
 };
 
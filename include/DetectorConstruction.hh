@@ -54,8 +54,7 @@ class DetectorConstruction : public G4VUserDetectorConstruction {
   void ConstructRegular();
 
   G4VPhysicalVolume* Construct();
-
-  TrackerSD* aTrackerSD;
+  void ConstructSDandField();//one TrackerSD per worker thread
 
   private:
     
@@ -64,6 +63,7 @@ class DetectorConstruction : public G4VUserDetectorConstruction {
   InputManager* InMgr;
 
   G4LogicalVolume* expHall_log;
+  G4LogicalVolume* crys1_log;
   G4Material* target;
   G4Material* BGO;
     
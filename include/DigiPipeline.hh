@@ -0,0 +1,66 @@
+#ifndef DigiPipeline_h
+#define DigiPipeline_h 1
+
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <functional>
+#include "Digitiser.hh"
+
+//Moves digitisation off the transport threads. At the end of an event the
+//transport thread only publishes the compact crystal deposit record into a
+//bounded lock-free ring (multi-producer, multi-consumer) and returns; the
+//digitiser threads take the records in batches and run the DAQ chain
+//(thresholds, resolution, sorting, histograms and output) on them.
+//When the ring is full Publish() waits for room (back-pressure, as
+//EventWriter), the digitiser threads free it at their own pace; transport
+//threads never digitise. Stop() drains the ring, joins the threads and
+//reports the load.
+
+class DigiPipeline {
+
+  public:
+
+  struct Deposit {
+    Int_t index;//cascade index of the event in its run
+    Raw_Event raw;
+  };
+
+  typedef std::function<void(int thread, const Deposit* batch, int n)> Stage;
+
+  DigiPipeline(int size);//ring length, rounded up to a power of 2
+ ~DigiPipeline();
+
+  void Start(int n_thread, Stage stage);
+  void Publish(int index, const Raw_Event& raw);//waits while the ring is full
+  void Stop();
+
+  private:
+
+  struct Cell {
+    std::atomic<size_t> seq;
+    Deposit dep;
+  };
+
+  bool TryPublish(int index, const Raw_Event& raw);
+  bool TryPop(Deposit& dep);
+  void Loop(int thread);
+
+  Cell* cells;
+  size_t mask;
+  char pad0[64];
+  std::atomic<size_t> head;//next publish
+  char pad1[64];
+  std::atomic<size_t> tail;//next take
+  char pad2[64];
+
+  std::vector<std::thread> threads;
+  std::atomic<bool> stop;
+  std::atomic<long long> published;
+  std::atomic<long long> stalls;//publishes that found the ring full
+  std::atomic<long long> batches;
+  Stage stage;
+
+};
+
+#endif
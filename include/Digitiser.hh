@@ -0,0 +1,86 @@
+#ifndef Digitiser_h
+#define Digitiser_h 1
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <Rtypes.h>
+#include <TRandom.h>
+#include "InputManager.hh"
+#include "Addback.hh"
+
+const int max_crys = 31;//TrackerSD copy numbers 0-30
+
+//one row of the Event tree ("sum/F:esort[10]:ecal[30]:Mult/I")
+struct Data_Event {
+  Float_t sum;//total energy, -1 = no coincidence
+  Float_t esort[10];//crystal energies in decending order
+  Float_t ecal[30];//crystal energies by detector number-1
+  Int_t Mult;//no. of crystals fired
+  Int_t Cluster;//no. of addback clusters (= Mult without addback), own "Cluster/I" branch
+};
+
+//one row of the Raw tree: the unsmeared deposits of one event, sparse,
+//keyed by crystal copy number
+struct Raw_Event {
+  Int_t Run;
+  Int_t n;//no. of crystals hit
+  Int_t det[max_crys];//copy number
+  Float_t dep[max_crys];//deposit MeV
+};
+
+//Turns the raw crystal deposits of one event into an Event tree row:
+//resolution smearing, gain/offset, crystal thresholds and dead crystals,
+//then addback of neighbouring crystals (optional), sorting and the E0
+//trigger. Every crystal has its own gain, offset, threshold, resolution
+//and enable flag (CrysFile, else the global values), kept as arrays
+//indexed by copy number so the per-event loop runs over all crystals at
+//once.
+//Shared by DAQManager and the offline tools, so every source of events
+//(Geant4, the response library, replays of the Raw tree) produces
+//identical quantities.
+
+class Digitiser {
+
+  public:
+
+  Digitiser();//Conv on, BGO resolution, no threshold or dead crystals
+  Digitiser(InputManager* InMgr);//Conv, res_k, res_scale, crys_threshold, E0_threshold, dead_crys, Addback, CrysFile
+  Digitiser(string line);//"name Conv res_k res_scale crys_threshold E0_threshold dead_crys [Addback [CrysFile]]"
+ ~Digitiser();
+
+  static void ReadList(string FileName, std::vector<Digitiser>& list);//one config per line
+
+  double Sigma(double E);//detector resolution (MeV), E in MeV, global res_k and res_scale
+  string GetName() {return name;};
+  bool GetAddback() {return addback;};
+  double GetTrigger() {return trigger;};
+  bool GetCrystal(int n, double& gain, double& offset, double& sigma, double& thres);//per crystal tables, false = disabled
+
+  void Digitise(const std::vector<double>& raw, const std::vector<int>& det, std::vector<double>& E, std::vector<int>& E_det, TRandom* rng);
+  bool Build(const std::vector<double>& E, const std::vector<int>& det, Data_Event& event, std::vector<double>& E_sort);
+  void Clear(Data_Event& event);
+
+  private:
+
+  void SetDead(string list);
+  void SetCrystals(string FileName);//per crystal tables, from the globals and CrysFile
+
+  string name;//histogram suffix of a fan-out config
+  bool Conv;//resolution smearing on/off
+  double k;//FWHM = k*sqrt(E)
+  double scale;//sigma scale factor
+  double threshold;//crystal threshold MeV, applied after smearing
+  double trigger;//E0 threshold MeV, a coincidence needs E0 above it
+  bool dead[max_crys];//masked crystals (dead_crys)
+  bool addback;//E_sort/esort/E0 from clusters of neighbouring crystals
+
+  double c_gain[max_crys];//per copy number: E = gain*E_smeared+offset
+  double c_offset[max_crys];
+  double c_threshold[max_crys];//MeV, 0 = none
+  double c_sigma[max_crys];//sigma = c_sigma*sqrt(E), 0 with Conv off
+  bool c_enable[max_crys];//false = dead_crys or disabled in CrysFile
+
+};
+
+#endif
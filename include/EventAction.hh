@@ -26,7 +26,7 @@ class EventAction : public G4UserEventAction {
 
   public:
 
-  EventAction(DAQManager* DAQMgr);
+  EventAction(DAQManager* DAQMgr, bool owner=false);//owner: deletes DAQMgr (worker instance)
  ~EventAction();
 
   void BeginOfEventAction(const G4Event*);
@@ -35,6 +35,7 @@ class EventAction : public G4UserEventAction {
 
   int GetCoinc() {return coinc;};
   void SetCoinc(int in) {coinc = in;};
+  DAQManager* GetDAQManager() const {return DAQMgr;};
 
   private:
 
@@ -44,6 +45,7 @@ class EventAction : public G4UserEventAction {
   int coinc;//no of coincident events this run
 
   DAQManager* DAQMgr;
+  bool owner;
 
 };
 
@@ -0,0 +1,106 @@
+#ifndef EventColumns_h
+#define EventColumns_h 1
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <stdint.h>
+#include "Digitiser.hh"
+
+using namespace std;
+
+//Columnar event file (.col), written next to the Event tree (EventColumns)
+//or converted from it (./columns), row i = Event tree entry i. Every field
+//of Data_Event (sum, esort0-9, ecal0-29, Mult, Cluster) and the cascade Run
+//is its own column of 32 bit values, cut into blocks of block_events
+//events. A block of a column is stored with zlib after a byte shuffle
+//(the 4 bytes of each value in 4 planes), or raw and 64 byte aligned if
+//that is not smaller or the level is 0. Each block records the min and max
+//of its values, so a selection skips the blocks that cannot pass.
+//Layout: ColHeader, the blocks, then the BlockInfo directory (block major)
+//at ColHeader::directory.
+//ColumnReader maps the file; a raw block is handed out as a pointer into
+//the mapping, a compressed one is inflated into a buffer of the reader,
+//valid until the next block of that column is asked for.
+
+namespace Columns {
+  enum Column {Sum = 0, Esort = 1, Ecal = 11, Mult = 41, Cluster = 42, Run = 43, n_column = 44};//Esort+k, Ecal+k
+  const int block_events = 65536;
+}
+
+struct ColHeader {
+  char magic[8];//"BGOCOL1"
+  int32_t n_column;
+  int32_t block_events;
+  int64_t n_event;
+  int32_t n_block;
+  int32_t level;//zlib level it was written with
+  int64_t directory;//byte offset of the BlockInfo directory
+  char pad[24];
+};
+
+struct BlockInfo {
+  int64_t offset;
+  int32_t bytes;//stored
+  int32_t packed;//1 = shuffled and deflated, 0 = raw
+  double min, max;
+};
+
+class ColumnWriter {
+
+  public:
+
+  ColumnWriter();
+ ~ColumnWriter();
+
+  bool Create(string FileName, int level);
+  void Fill(const Data_Event& event, Int_t run);
+  bool Finish();//last block and directory, then closes the file
+
+  private:
+
+  void WriteBlock();
+
+  FILE* f;
+  int level;
+  int64_t n_event;
+  int n;//events in the current block
+  std::vector<float> buffer;//column major, Columns::n_column x block_events
+  std::vector<BlockInfo> directory;
+  std::vector<unsigned char> packed;
+
+};
+
+class ColumnReader {
+
+  public:
+
+  ColumnReader();
+ ~ColumnReader();
+
+  bool Open(string FileName);//false (with a message) if it is not a column file
+  void Close();
+
+  int64_t NEvents() const {return header->n_event;};
+  int NBlocks() const {return header->n_block;};
+  int BlockEvents(int b) const;
+
+  const float* Float(int column, int b);//Sum, Esort, Ecal
+  const Int_t* Int(int column, int b) {return (const Int_t*)Float(column,b);};//Mult, Cluster, Run
+
+  const BlockInfo& Info(int column, int b) const {return directory[b*header->n_column+column];};
+  bool Overlaps(int column, int b, double low, double high) const;//false = no value of the block in [low,high]
+
+  private:
+
+  void* map;
+  size_t size;
+  const ColHeader* header;
+  const BlockInfo* directory;
+  std::vector<std::vector<float> > cache;//per column, inflated block
+  std::vector<int> cached;//block in the cache, -1 = none
+  std::vector<unsigned char> scratch;
+
+};
+
+#endif
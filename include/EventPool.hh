@@ -0,0 +1,42 @@
+#ifndef EventPool_h
+#define EventPool_h 1
+
+#include <vector>
+#include <Rtypes.h>
+#include <TRandom.h>
+#include "Digitiser.hh"
+
+//Indexed pool of single gamma events per energy, read from the Raw trees of
+//"Library" runs. A cascade event is synthesised by drawing one pool event per
+//gamma and summing the deposits crystal by crystal, so crystal sharing
+//between the gammas of a cascade is kept.
+
+class EventPool {
+
+  public:
+
+  EventPool();
+ ~EventPool();
+
+  void Read(const char* FileName);//adds the energies of one library file
+  void AddGamma(double E, double deposit[max_crys], TRandom* rng);//one gamma of E MeV
+
+  int GetNEnergies() {return E_grid.size();};
+  double GetEmin() {return E_grid.front();};
+  double GetEmax() {return E_grid.back();};
+
+  private:
+
+  struct Energy {
+    double E;
+    std::vector<int> offset;//event i is hits offset[i]...offset[i+1]-1
+    std::vector<unsigned char> det;
+    std::vector<float> dep;
+  };
+
+  std::vector<Energy> grid;//sorted in energy
+  std::vector<double> E_grid;//grid[i].E, for the binary search
+
+};
+
+#endif
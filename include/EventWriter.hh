@@ -0,0 +1,69 @@
+#ifndef EventWriter_h
+#define EventWriter_h 1
+
+#include <thread>
+#include <atomic>
+#include <TTree.h>
+#include "Digitiser.hh"
+#include "EventColumns.hh"
+#include "RunSegments.hh"
+
+//Fills the Event (and Raw) tree on a dedicated thread, so basket compression
+//and disk writes do not stall transport. Simulation threads push fixed-size
+//records into a bounded lock-free queue (multi-producer, one consumer) and
+//wait for room when it is full. Stop() drains the queue, joins the thread
+//and reports the writer throughput.
+
+class EventWriter {
+
+  public:
+
+  EventWriter(int size);//queue length, rounded up to a power of 2
+ ~EventWriter();
+
+  void Start(TTree* EventTree, TTree* RawTree, ColumnWriter* columns, RunSegments* segments);//0 = no Raw tree, no column file, no index
+  void Push(const Data_Event& data, Int_t run, const Raw_Event* raw);
+  void Stop();
+
+  private:
+
+  struct Record {
+    Data_Event data;
+    Int_t run;
+    Raw_Event raw;
+  };
+
+  struct Cell {
+    std::atomic<size_t> seq;
+    Record rec;
+  };
+
+  bool TryPush(const Data_Event& data, Int_t run, const Raw_Event* raw);
+  bool TryPop(Record& rec);
+  void Loop();
+
+  Cell* cells;
+  size_t mask;
+  char pad0[64];
+  std::atomic<size_t> head;//next push
+  char pad1[64];
+  std::atomic<size_t> tail;//next pop
+  char pad2[64];
+
+  std::thread writer;
+  std::atomic<bool> stop;
+  std::atomic<long long> stalls;//pushes that found the queue full
+
+  TTree* EventTree;
+  TTree* RawTree;
+  ColumnWriter* columns;
+  RunSegments* segments;
+  Record out;//branch buffers, only touched by the writer thread
+
+  long long N_written;
+  double busy;//seconds spent filling
+  double wall;//seconds from Start to Stop
+
+};
+
+#endif
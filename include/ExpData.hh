@@ -0,0 +1,63 @@
+#ifndef ExpData_h
+#define ExpData_h 1
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+using namespace std;
+
+//Experimental reference dataset in a flat binary file (.bin): a fixed
+//header with the metadata, then either the bin contents (double, x
+//fastest) or the events (n_var floats each). ExpData maps the file
+//read-only, so loading costs no copy and many datasets can be scored in
+//one pass. ./expdata converts the text form (E0E1_exp.txt etc.).
+
+struct ExpHeader {
+  char magic[8];//"BGOEXP1"
+  int32_t quantity;//ExpData::Quantity
+  int32_t kind;//ExpData::Kind
+  int32_t run;//experimental run the data is from, 0 = unknown
+  int32_t n_var;//values per event, 1 (x) or 2 (x y)
+  float threshold[2];//E0 and E1 thresholds (MeV) of the selection
+  int32_t n_x;
+  int32_t n_y;//0 = 1D
+  double x_min, x_max;
+  double y_min, y_max;
+  int64_t n;//bins (n_x*n_y) or events
+  char name[64];
+};
+
+class ExpData {
+
+  public:
+
+  enum Quantity {Mult, E0, E0E1, GammaGamma};//Mult-1 | E0 | E0 vs E1, with esort[0] > t0 (|| esort[1] > t1 for E0E1) | gamma pairs, higher first
+  enum Kind {Binned, Events};
+
+  ExpData();
+ ~ExpData();
+
+  bool Open(string FileName);//false (with a message) if it is not a dataset
+  void Close();
+
+  const ExpHeader& Header() const {return *header;};
+  const double* BinData() const;//Binned only
+  const float* EventData() const;//Events only
+
+  int NBins() const;
+  int Bin(double x, double y) const;//index into the bins, -1 = outside the axes
+  void GetBins(std::vector<double>& bins) const;//events are binned on the axes
+
+  static bool Write(string FileName, const ExpHeader& h, const void* payload);
+  static bool ParseQuantity(string name, int& q);
+
+  private:
+
+  void* map;
+  size_t size;
+  const ExpHeader* header;
+
+};
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef Histogram_h
+#define Histogram_h 1
+
+#include <atomic>
+#include "TH1.h"
+#include "TH2.h"
+
+//Fixed binning 1D/2D counting histogram that any number of threads can fill
+//at once: the bins are one contiguous, cache-line aligned array of relaxed
+//atomic counters, so there is no per-thread copy to merge and nothing to
+//allocate per run (Reset() zeroes it). Bin numbering, under- and overflow
+//follow ROOT; a TH1F/TH2F is only made when it is written (ToTH1F/ToTH2F).
+//Reads (GetBinContent, conversion) see the fills completed so far.
+
+class Histogram {
+
+  public:
+
+  Histogram(int nx, double xmin, double xmax);
+  Histogram(int nx, double xmin, double xmax, int ny, double ymin, double ymax);
+ ~Histogram();
+
+  void Fill(double x) {
+    bins[FindBin(x,nx,xmin,xscale)].fetch_add(1,std::memory_order_relaxed);
+  };
+  void Fill(double x, double y) {
+    bins[FindBin(x,nx,xmin,xscale)+stride*FindBin(y,ny,ymin,yscale)].fetch_add(1,std::memory_order_relaxed);
+  };
+
+  void Reset();
+  unsigned int GetBinContent(int binx, int biny=0) const;
+  double GetEntries() const;//all fills, including under/overflow
+
+  TH1F* ToTH1F(const char* name) const;//new histogram in the current directory
+  TH2F* ToTH2F(const char* name) const;
+
+  private:
+
+  Histogram(const Histogram&);//not copyable
+  Histogram& operator=(const Histogram&);
+
+  void Allocate();
+
+  static int FindBin(double v, int n, double min, double scale) {
+    if (!(v>=min)) return 0;//underflow (and NaN)
+    double b = (v-min)*scale;
+    if (b>=n) return n+1;//overflow
+    return 1+int(b);
+  };
+
+  int nx, ny;//ny = 0 for 1D
+  double xmin, xmax, xscale;
+  double ymin, ymax, yscale;
+  int stride;//nx+2
+  int n_cell;//(nx+2)*(ny+2)
+
+  char* memory;
+  std::atomic<unsigned int>* bins;
+
+};
+
+#endif
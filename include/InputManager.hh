@@ -27,14 +27,13 @@ class InputManager {
   private:
   const char* filename;
   std::map <string,string> config_var;
-  std::map <string,string>::iterator it;
 
 };
 
 template <class T>
 void InputManager::GetVariable(string name,T& value) {
 
-  it = config_var.find(name);
+  std::map <string,string>::const_iterator it = config_var.find(name);//local, so worker threads can read concurrently
 
   if (it==config_var.end()) {
     cerr << "Error in <InputManager::GetVariable>: Variable " << name << " is not in "<< filename << endl;
@@ -0,0 +1,50 @@
+#ifndef Likelihood_h
+#define Likelihood_h 1
+
+#include <vector>
+#include <string>
+
+//Goodness of fit of simulated templates to one experimental histogram, in
+//log space (no pow/factorial overflow). The experimental bins are fixed at
+//construction and the sum of their lgamma(X+1) is taken once; the
+//normalisation N = s M of a template M is folded into the sums (as in
+//SparseTemplates), so the bin loops read the template in place and are
+//branch free for the compiler to vectorise. Templates are normalised to the
+//experimental integral unless told otherwise. Evaluate and Batch are const:
+//one instance per dataset can be shared by any number of threads.
+//
+//  Poisson  -2lnL = -2 sum[X ln N - N - lgamma(X+1)]
+//  Pearson  chi2  = sum (X-N)^2/N
+//  Neyman   chi2  = sum (X-N)^2/max(X,1)
+//  Cash     C     = 2 sum[N - X ln N]
+//
+//An empty template bin under data (N=0, X>0) makes Poisson, Pearson and Cash
+//infinite (HUGE_VAL) instead of NaN.
+
+class Likelihood {
+
+  public:
+
+  enum Statistic {Poisson, Pearson, Neyman, Cash};
+
+  Likelihood(const std::vector<double>& data);
+ ~Likelihood();
+
+  static bool Parse(const std::string& name, Statistic& s);//"poisson", "pearson", "neyman", "cash"
+
+  double Evaluate(const double* model, Statistic s, bool normalise=true) const;
+  void Batch(const double* models, int n_model, Statistic s, double* result, bool normalise=true) const;//models[m*n_bin+i]
+
+  int GetNBins() const {return n_bin;};
+
+  private:
+
+  int n_bin;
+  double total;//experimental integral
+  double lg_total;//sum lgamma(X+1)
+  double neyman_data;//sum X^2/max(X,1)
+  std::vector<double> X;
+
+};
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef MixtureFit_h
+#define MixtureFit_h 1
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+//Fits an experimental histogram as a non-negative mixture of simulated
+//templates (one per cascade run of a sweep):  y ~ A w,  w >= 0.
+//  EM    Poisson maximum likelihood, multiplicative ML-EM updates
+//  NNLS  Neyman chi2 sum (y-Aw)^2/max(y,1), accelerated projected gradient
+//Both only need the two products m = A w and g = A^T v. The templates are
+//stored contiguously one after another and the products are split over a
+//persistent thread pool by template blocks, in bin tiles that stay in L1,
+//so thousands of templates fit interactively.
+
+class MixtureFit {
+
+  public:
+
+  MixtureFit(int n_bin, int n_thread);
+ ~MixtureFit();
+
+  void AddTemplate(const std::vector<double>& t);//expected counts per bin per unit weight
+  void SetData(const std::vector<double>& y);
+  int GetNTemplates() {return n_tmpl;};
+  int GetNBins() {return n_bin;};
+
+  int EM(std::vector<double>& w, int max_iter, double tol);//returns the iterations used
+  int NNLS(std::vector<double>& w, int max_iter, double tol);
+
+  void Model(const std::vector<double>& w, std::vector<double>& m);//A w
+  double Deviance(const std::vector<double>& m);//Poisson, 2 sum[m - y + y ln(y/m)]
+  double Neyman(const std::vector<double>& m);//sum (y-m)^2/max(y,1)
+  double Counts(int t) {return colsum[t];};//template integral
+
+  private:
+
+  void Forward(const double* w, double* m);//m = A w
+  void Back(const double* v, double* g);//g = A^T v
+  void Parallel(const std::function<void(int,int)>& job);//job(thread, n_thread) on every thread
+  void Worker(int thread);
+
+  int n_bin;
+  int n_tmpl;
+  std::vector<double> A;//A[t*n_bin+b]
+  std::vector<double> colsum;
+  std::vector<double> y;
+  std::vector<std::vector<double> > partial;//per thread bins of Forward
+
+  int n_thread;
+  std::vector<std::thread> pool;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable finished;
+  const std::function<void(int,int)>* current;
+  long long generation;
+  int busy;
+  bool quit;
+
+};
+
+#endif
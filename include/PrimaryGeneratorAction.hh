@@ -8,6 +8,7 @@
 
 class G4ParticleGun;
 class G4Event;
+class TF1;
 
 class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
 {
@@ -29,6 +30,10 @@ class PrimaryGeneratorAction : public G4VUserPrimaryGeneratorAction
   private:
     G4ParticleGun* particleGun;
     CascadeGenerator* CasGen;
+
+    int decaynum;//per-thread decay bookkeeping
+    double phi_old;
+    TF1* f3;//60Co angular correlation
     
 };
 
@@ -0,0 +1,49 @@
+#ifndef ResponseFold_h
+#define ResponseFold_h 1
+
+#include <vector>
+#include "TH1.h"
+#include "TH2.h"
+#include "Digitiser.hh"
+
+//Folds the cascade spectra out of the single gamma response library at the
+//distribution level, without drawing events. The library is the raw
+//deposit distribution of every crystal per gamma energy (Lib_%i of a
+//"Library" run, 10 keV bins). For a cascade the deposits of its gammas are
+//convolved crystal by crystal, every crystal is digitised as a density
+//(gain, offset, resolution, threshold and dead crystals of the Digitiser)
+//and the Mult_, E_ and Etot_ spectra of the coincidences (E0 above
+//E0_threshold) follow with the crystals taken as independent. Crystal
+//sharing is lost, EventPool keeps it at the cost of sampling. No addback.
+
+class ResponseFold {
+
+  public:
+
+  ResponseFold(Digitiser& D);
+ ~ResponseFold();
+
+  void Read(const char* FileName);//adds the Lib_ histograms of one library file
+  double Fold(const std::vector<double>& cascade, double N_events, TH2F* h_E, TH1F* h_Etot, TH1F* h_mult);//expected counts, returns the efficiency
+
+  int GetNEnergies() {return E_grid.size();};
+
+  private:
+
+  struct Energy {
+    double E;
+    double n_event;//gammas simulated
+    std::vector<double> count;//deposits of crystal n at n*n_dep
+  };
+
+  void Gamma(double E, std::vector<double>& p);//crystal n at n*(n_fold+1): not hit, then deposit bins
+  void Response(int n, const double* dep, double* out);//digitised density of crystal n
+
+  Digitiser& Digi;
+
+  std::vector<Energy> grid;//sorted in energy
+  std::vector<double> E_grid;//grid[i].E, for the binary search
+
+};
+
+#endif
@@ -2,6 +2,7 @@
 #define RunAction_h 1
 
 #include "G4UserRunAction.hh"
+#include "G4Version.hh"
 #include "CascadeGenerator.hh"
 #include "DAQManager.hh"
 
@@ -21,6 +22,10 @@ public:
   void E01Likelihood();
   void MultLikelihood();
 
+  #if G4VERSION_NUMBER<1000
+  G4bool IsMaster() const {return true;};//Geant4 9.x runs sequentially
+  #endif
+
 private:
   G4double sumEAbs, sum2EAbs;
   G4double sumEGap, sum2EGap;
@@ -0,0 +1,57 @@
+#ifndef RunSegments_h
+#define RunSegments_h 1
+
+#include <vector>
+#include <algorithm>
+#include <Rtypes.h>
+
+//Contiguous stretches of one cascade run in the Event tree, recorded as the
+//tree is filled. Events of a sweep arrive nearly in event ID order, so each
+//run is one stretch or a few around the cascade boundaries; RunIndex gets
+//one row per stretch and a run is read without scanning its neighbours.
+//Filled by whoever fills the Event tree, under that filler's lock.
+
+class RunSegments {
+
+  public:
+
+  RunSegments() : next(0) {};
+
+  struct Segment {
+    Int_t run;
+    Long64_t first;
+    Long64_t entries;
+  };
+
+  void Start(Long64_t entry) {//Event tree entries of the Geant4 run from here on
+    list.clear();
+    next = entry;
+  };
+
+  void Add(Int_t run) {//the entry just filled belongs to run
+    if (list.size()==0 || list.back().run!=run) {
+      Segment s = {run,next,0};
+      list.push_back(s);
+    }
+    list.back().entries += 1;
+    next += 1;
+  };
+
+  std::vector<Segment> Sorted() const {//by run, then entry
+    std::vector<Segment> s = list;
+    std::sort(s.begin(),s.end(),Before);
+    return s;
+  };
+
+  private:
+
+  static bool Before(const Segment& a, const Segment& b) {
+    return (a.run<b.run) || (a.run==b.run && a.first<b.first);
+  };
+
+  std::vector<Segment> list;
+  Long64_t next;
+
+};
+
+#endif
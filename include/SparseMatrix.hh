@@ -0,0 +1,46 @@
+#ifndef SparseMatrix_h
+#define SparseMatrix_h 1
+
+#include <vector>
+#include <Rtypes.h>
+
+const int sparse_bins = 1500;//0-15 MeV in 10 keV bins on both axes, as h_E
+const double sparse_max = 15.;
+
+//Fine 2D spectrum of one cascade kept sparse: bin keys row*sparse_bins+col
+//are appended per event and every so often sorted and run-length merged
+//into (key,count) pairs, so memory follows the occupied bins, not the
+//1500x1500 grid. Per-thread matrices are merged at end of run and written
+//as compressed sparse rows (ToCSR) to the Sparse tree.
+
+class SparseMatrix {
+
+  public:
+
+  SparseMatrix();
+ ~SparseMatrix();
+
+  static int Bin(double E);//-1 outside 0-15 MeV
+
+  void Add(int row, int col) {
+    pending.push_back(UInt_t(row)*sparse_bins+col);
+    if (pending.size() >= flush_size) Flush();
+  };
+  void Flush();
+  void Merge(SparseMatrix& other);//other is emptied
+  void Clear();
+
+  int GetNonZero() {Flush(); return keys.size();};
+  void ToCSR(std::vector<Int_t>& row_ptr, std::vector<UShort_t>& col, std::vector<UInt_t>& val);//row_ptr has sparse_bins+1 entries
+
+  private:
+
+  static const unsigned int flush_size = 1<<16;
+
+  std::vector<UInt_t> pending;//unsorted keys since the last flush
+  std::vector<UInt_t> keys;//sorted, unique
+  std::vector<UInt_t> counts;
+
+};
+
+#endif
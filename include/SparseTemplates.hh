@@ -0,0 +1,65 @@
+#ifndef SparseTemplates_h
+#define SparseTemplates_h 1
+
+#include <vector>
+#include <Rtypes.h>
+#include "Likelihood.hh"
+
+//Goodness of fit of many sparse 2D templates (CSR matrices of the Sparse
+//tree, rebinned onto the dataset axes) to one experimental matrix, touching only the
+//non-zero template bins. All occupied bins of the data and the templates go
+//into one shared, sorted bin dictionary; each template keeps its bins as
+//dictionary positions plus two aligned arrays, its contents and the data in
+//the same bins. With the normalisation folded in analytically every
+//statistic is one or two streaming sums over these arrays (sum x ln v,
+//sum x^2/v, ...), which the compiler vectorises:
+//  Poisson/Cash  need sum x ln v,   infinite if data lies outside the template
+//  Pearson       needs sum x^2/v,   same
+//  Neyman        needs sum v^2/m and sum x v/m, m = max(x,1)
+//The definitions are those of Likelihood, template scaled to the data.
+
+class SparseTemplates {
+
+  public:
+
+  SparseTemplates(int n_x, double x_min, double x_max, int n_y, double y_min, double y_max);
+ ~SparseTemplates();
+
+  bool IsAligned() {return fx>0 && fy>0;};//data bin edges on the 10 keV template edges
+
+  void SetData(const std::vector<double>& dense);//bins x (row) fastest, as ExpData
+  int AddCSR(const Int_t* row_ptr, const UShort_t* col, const UInt_t* val, double t0, double t1);//bins below both thresholds dropped
+  void Finalise();//builds the dictionary, call once after the last AddCSR
+
+  int GetNTemplates() {return tmpl.size();};
+  int GetNonZero(int t) {return tmpl[t].v.size();};
+  int GetDictionarySize() {return dict.size();};
+
+  double Evaluate(int t, Likelihood::Statistic s);
+  void Batch(Likelihood::Statistic s, std::vector<double>& result);
+
+  private:
+
+  struct Template {
+    std::vector<UInt_t> key;//until Finalise
+    std::vector<UInt_t> pos;//dictionary positions
+    std::vector<float> v;//contents
+    std::vector<float> x;//data at the same bins
+    double V;//sum v
+  };
+
+  int fx, fy;//template bins per data bin, 0 = not aligned
+  int ox, oy;//template bin of the first data bin
+  int n_x, n_y;
+  std::vector<UInt_t> data_key;//occupied data bins, sorted
+  std::vector<double> data_val;
+  double X_total;
+  double lg_total;//sum lgamma(X+1)
+  double neyman_data;//sum X^2/max(X,1)
+
+  std::vector<UInt_t> dict;//all occupied bins, sorted
+  std::vector<Template> tmpl;
+
+};
+
+#endif
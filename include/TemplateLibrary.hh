@@ -0,0 +1,73 @@
+#ifndef TemplateLibrary_h
+#define TemplateLibrary_h 1
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+
+using namespace std;
+
+//All sweep results in one binary file (./packlib), so an analysis maps it
+//instead of opening a Run_N.root per run. Layout, every block 64 byte
+//aligned:
+//  LibHeader
+//  LibRun index, one per run, sorted by run number
+//  spectra, one fixed size record per run in index order:
+//    Mult-1 (10 bins 0-10), Etot (200, 0-20 MeV), E0 and E1 (1500, 0-15 MeV)
+//The file is mapped read-only, so processes share it through the page
+//cache; a lookup is a binary search in the index and a pointer.
+
+struct LibHeader {
+  char magic[8];//"BGOLIB1"
+  int32_t n_run;
+  int32_t n_bin[4];//bins of each spectrum, TemplateLibrary::Spectrum
+  float max[4];//upper axis edge, the lower is 0
+  int32_t pad;
+  int64_t index;//byte offset of the LibRun index
+  int64_t data;//byte offset of the first record
+  int64_t record;//bytes per run record
+};
+
+struct LibRun {
+  int32_t run;
+  int32_t n_event;//simulated events (Run tree)
+  int32_t n_coinc;//events with E0 above threshold
+  float eff;//n_coinc/n_event
+  float cascade[10];//MeV, 0 = unused
+  int32_t n_gamma;
+  int32_t pad;
+};
+
+class TemplateLibrary {
+
+  public:
+
+  enum Spectrum {Mult, Etot, E0, E1};
+
+  TemplateLibrary();
+ ~TemplateLibrary();
+
+  bool Open(string FileName);//false (with a message) if it is not a library
+  void Close();
+
+  const LibHeader& Header() const {return *header;};
+  int NRuns() const {return header->n_run;};
+  int NBins(Spectrum s) const {return header->n_bin[s];};
+
+  const LibRun& GetRun(int i) const {return index[i];};//i-th in run order
+  int Find(int run) const;//position in the index, -1 = not in the library
+  const float* Get(int i, Spectrum s) const;//contents of bins 1...n of the i-th run
+
+  static void Layout(LibHeader& h, int n_run);//offsets and record size for n_run runs
+  static bool Write(string FileName, const std::vector<LibRun>& runs, const std::vector<float>& spectra);//spectra: records in the order of runs
+
+  private:
+
+  void* map;
+  size_t size;
+  const LibHeader* header;
+  const LibRun* index;
+
+};
+
+#endif
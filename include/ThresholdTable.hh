@@ -0,0 +1,40 @@
+#ifndef ThresholdTable_h
+#define ThresholdTable_h 1
+
+#include <vector>
+#include "TH2.h"
+
+//Threshold queries on the E0Mult_N (E0 vs multiplicity) and E0E1_N (E0 vs
+//E1) tables DAQManager writes for each run, without re-reading events.
+//Prefix sums are built once, every query is then a lookup. A threshold t
+//selects the E0 (E1) bins whose lower edge is at or above t, i.e. t is
+//rounded up to the table binning (0.01 MeV in E0Mult, 0.05 MeV in E0E1).
+
+class ThresholdTable {
+
+  public:
+
+  ThresholdTable(TH2* E0Mult, TH2* E0E1, double N_event);
+ ~ThresholdTable();
+
+  double Efficiency(double t0);//fraction of events with E0 > t0
+  void Multiplicity(double t0, std::vector<double>& mult);//events by Mult-1 (as Mult_N) with E0 > t0
+  double Fraction(double t0, double t1);//fraction of events with E0 > t0 or E1 > t1
+
+  private:
+
+  int Edge(double t, double min, double width, int n);//first bin at or above t
+
+  double N_event;
+
+  int n0, n_mult;//E0Mult
+  double min0, width0;
+  std::vector<double> above;//above[b*n_mult+m]: events in Mult bin m and E0 bins b...n0+1
+
+  int m0, m1;//E0E1
+  double min01, width01, min1, width1;
+  std::vector<double> below;//below[a*(m1+1)+b]: events in E0 bins <a and E1 bins <b (from underflow)
+
+};
+
+#endif
@@ -13,6 +13,7 @@
 #include <TFile.h>
 #include <TStyle.h>
 #include "TRandom.h"
+#include "Randomize.hh"
 #include <vector>
 #include <cstdlib>
 #include "DAQManager.hh"
@@ -58,6 +59,11 @@ class TrackerSD : public G4VSensitiveDetector {
   G4ThreeVector  location;
   G4int eventno;
   G4int copynum;
+  G4int HCID;
+
+
+  G4double E_crys[31];//energy deposited per crystal this event, index=copy number
+  G4double BGO_x[31];
 
   DAQManager* DAQMgr;
 
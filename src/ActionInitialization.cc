@@ -0,0 +1,49 @@
+#include "ActionInitialization.hh"
+
+#if G4VERSION_NUMBER>=1000
+
+#include "G4Threading.hh"
+#include "PrimaryGeneratorAction.hh"
+#include "RunAction.hh"
+#include "EventAction.hh"
+
+ActionInitialization::ActionInitialization(CascadeGenerator* aCasGen, DAQManager* aDAQMgr) {
+
+  CasGen = aCasGen;
+  DAQMgr = aDAQMgr;
+
+}
+
+//-------------------------------------------------------------------------
+
+ActionInitialization::~ActionInitialization() {
+
+}
+
+//-------------------------------------------------------------------------
+//master thread of a multithreaded run: only run bookkeeping, no events
+
+void ActionInitialization::BuildForMaster() const {
+
+  SetUserAction(new RunAction(CasGen,DAQMgr));
+
+}
+
+//-------------------------------------------------------------------------
+//called once per worker thread (or once in sequential mode)
+
+void ActionInitialization::Build() const {
+
+  DAQManager* aDAQMgr = DAQMgr;
+
+  if (G4Threading::IsWorkerThread()) {
+    aDAQMgr = new DAQManager(DAQMgr);//thread-local event buffers and histograms
+  }
+
+  SetUserAction(new PrimaryGeneratorAction(CasGen));
+  SetUserAction(new RunAction(CasGen,aDAQMgr));
+  SetUserAction(new EventAction(aDAQMgr,aDAQMgr!=DAQMgr));//the worker instance goes with its EventAction
+
+}
+
+#endif
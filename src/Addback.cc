@@ -0,0 +1,142 @@
+#include "Addback.hh"
+#include "TTree.h"
+#include <cmath>
+#include <iostream>
+
+using namespace std;
+
+double Addback::pos[max_neighbour][3];
+bool Addback::placed[max_neighbour] = {};
+UInt_t Addback::mask[max_neighbour] = {};
+bool Addback::built = false;
+
+namespace {
+
+  inline int Lowest(UInt_t m) {
+    return __builtin_ctz(m);//index of the lowest set bit, m != 0
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+void Addback::SetPosition(int det, double x, double y, double z) {
+
+  if (det<0 || det>=max_neighbour) {
+    cerr << "error: crystal copy number " << det << " has no neighbour bit" << endl;
+    exit(1);
+  }
+
+  pos[det][0] = x;
+  pos[det][1] = y;
+  pos[det][2] = z;
+  placed[det] = true;
+
+}
+
+//-------------------------------------------------------------------------
+//neighbouring hexagonal cases touch at a centre distance of the flat to
+//flat width (5.886 cm in the Regular array), the next ring is ~10 cm away
+
+void Addback::Build(double dist) {
+
+  for (int i=0; i<max_neighbour; i++) {
+
+    mask[i] = 0;
+    if (placed[i] == false) continue;
+
+    for (int j=0; j<max_neighbour; j++) {
+
+      if (j == i || placed[j] == false) continue;
+
+      double dx = pos[i][0]-pos[j][0];
+      double dy = pos[i][1]-pos[j][1];
+      double dz = pos[i][2]-pos[j][2];
+
+      if (sqrt(dx*dx+dy*dy+dz*dz) < dist) mask[i] |= (1u<<j);
+
+    }
+
+  }
+
+  built = true;
+
+}
+
+//-------------------------------------------------------------------------
+
+void Addback::Write() {
+
+  if (built == false) return;
+
+  TTree* t = new TTree("Neighbours", "Neighbours");
+  t->Branch("mask", mask, "mask[31]/i");//bit j of mask[i]: j is next to i
+  t->Fill();
+  t->Write();
+
+  delete t;
+
+}
+
+//-------------------------------------------------------------------------
+
+bool Addback::Read(TFile* f) {
+
+  TTree* t = (TTree*)f->Get("Neighbours");
+  if (t == 0 || t->GetEntries() == 0) return false;
+
+  t->SetBranchAddress("mask", mask);
+  t->GetEntry(0);
+  t->ResetBranchAddresses();
+
+  built = true;
+
+  return true;
+
+}
+
+//-------------------------------------------------------------------------
+//E[i] is the energy of crystal det[i]. Each cluster starts from the lowest
+//fired bit and grows by the neighbours of its newest members until it stops
+//changing; E_cluster gets the summed energy of every cluster
+
+void Addback::Cluster(const std::vector<double>& E, const std::vector<int>& det, std::vector<double>& E_cluster) {
+
+  double sum[max_neighbour];
+  UInt_t fired = 0;
+
+  for (int i=0; i<E.size(); i++) {
+    UInt_t bit = 1u<<det[i];
+    if ((fired & bit) == 0) sum[det[i]] = 0;
+    fired |= bit;
+    sum[det[i]] += E[i];
+  }
+
+  E_cluster.clear();
+
+  while (fired) {
+
+    UInt_t cluster = fired & (~fired+1);//lowest fired crystal
+    UInt_t front = cluster;
+
+    while (front) {
+      UInt_t grown = cluster;
+      for (UInt_t m=front; m; m&=m-1) {
+        grown |= mask[Lowest(m)];
+      }
+      grown &= fired;
+      front = grown & ~cluster;//members added in this step
+      cluster = grown;
+    }
+
+    fired &= ~cluster;
+
+    double E_sum = 0;
+    for (UInt_t m=cluster; m; m&=m-1) {
+      E_sum += sum[Lowest(m)];
+    }
+    E_cluster.push_back(E_sum);
+
+  }
+
+}
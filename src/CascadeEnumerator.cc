@@ -0,0 +1,135 @@
+#include "CascadeEnumerator.hh"
+
+CascadeEnumerator::CascadeEnumerator(int an_gamma, int an_step) {
+
+  n_gamma = an_gamma;
+  n_step = an_step;
+
+  table.resize((n_step+1)*(n_gamma+1));
+
+  for (int s=0; s<=n_step; s++) {//P(s,k) = P(s,k-1) + P(s-k,k)
+    for (int k=0; k<=n_gamma; k++) {
+      long long p;
+      if (s==0) p = 1;
+      else if (k==0) p = 0;
+      else {
+        p = table[s*(n_gamma+1)+k-1];
+        if (s>=k) p += table[(s-k)*(n_gamma+1)+k];
+      }
+      table[s*(n_gamma+1)+k] = p;
+    }
+  }
+
+}
+
+//-------------------------------------------------------------------
+
+CascadeEnumerator::~CascadeEnumerator() {
+
+}
+
+//-------------------------------------------------------------------
+
+long long CascadeEnumerator::Partitions(int s, int k) {
+
+  if (s<0) return 0;
+
+  return table[s*(n_gamma+1)+k];
+
+}
+
+//-------------------------------------------------------------------
+//subtracting v from every step leaves a partition of s-k*v into at most k parts
+
+long long CascadeEnumerator::Completions(int s, int k, int v) {
+
+  return Partitions(s-k*v,k);
+
+}
+
+//-------------------------------------------------------------------
+
+void CascadeEnumerator::Unrank(long long k, std::vector<int>& step) {
+
+  step.resize(n_gamma);
+
+  int s = n_step;//energy left to distribute
+  int v = 0;//lower bound, steps are non-decreasing
+
+  for (int a=0; a<n_gamma; a++) {
+
+    int left = n_gamma-a-1;//steps after this one
+
+    for (;; v++) {
+      long long c = Completions(s-v,left,v);
+      if (k<c || v>=s) break;
+      k -= c;
+    }
+
+    step[a] = v;
+    s -= v;
+
+  }
+
+}
+
+//-------------------------------------------------------------------
+
+long long CascadeEnumerator::Rank(const std::vector<int>& step) {
+
+  long long k = 0;
+
+  int s = n_step;
+  int v = 0;
+
+  for (int a=0; a<n_gamma; a++) {
+
+    int left = n_gamma-a-1;
+
+    for (; v<step[a]; v++) {
+      k += Completions(s-v,left,v);
+    }
+
+    s -= step[a];
+
+  }
+
+  return k;
+
+}
+
+//-------------------------------------------------------------------
+//lexicographic successor: raise the rightmost step that still leaves a
+//valid tail, then make the tail as small as possible
+
+bool CascadeEnumerator::Next(std::vector<int>& step) {
+
+  int prefix = n_step;//energy left after step[0..a-1]
+  std::vector<int> left(n_gamma);
+
+  for (int a=0; a<n_gamma; a++) {
+    left[a] = prefix;
+    prefix -= step[a];
+  }
+
+  for (int a=n_gamma-2; a>=0; a--) {
+
+    int v = step[a]+1;
+    int rest = left[a]-v;//to share between the n_gamma-a-1 later steps
+    int n_tail = n_gamma-a-1;
+
+    if (rest<v*n_tail) continue;
+
+    step[a] = v;
+    for (int b=a+1; b<n_gamma-1; b++) {
+      step[b] = v;
+    }
+    step[n_gamma-1] = rest-v*(n_tail-1);
+
+    return true;
+
+  }
+
+  return false;
+
+}
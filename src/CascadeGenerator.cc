@@ -1,4 +1,7 @@
 #include "CascadeGenerator.hh"
+#include <climits>
+#include <cmath>
+#include <algorithm>
 
 CascadeGenerator::CascadeGenerator(InputManager* aInMgr) {
 
@@ -6,12 +9,28 @@ CascadeGenerator::CascadeGenerator(InputManager* aInMgr) {
 
   InMgr->GetVariable("run_start",N_run);
 //  N_run-=1;
-  n_gamma = 5;//no of gammas
+  InMgr->GetVariable("n_gammas",n_gamma);//no of gammas
   InMgr->GetVariable("n_bin",n_bin);
   n_bin+=1;
   InMgr->GetVariable("run_end",run_end);
-  run_end-=1;
-  count = 0;
+  InMgr->GetVariable("N_events",N_events);
+  InMgr->GetVariable("cascades_per_run",cascades_per_run);
+  n_cascade = 1;
+  CasEnum = 0;
+  first_run = 0;
+  n_total = 1;
+
+  if (n_gamma<1 || n_gamma>max_gamma) {
+    G4cout << "error: n_gammas must be between 1 and " << max_gamma << G4endl;
+    exit(1);
+  }
+
+  if (cascades_per_run<1) cascades_per_run = 1;
+  if (cascades_per_run>INT_MAX/N_events) {//beamOn takes an int
+    cascades_per_run = INT_MAX/N_events;
+    G4cout << "CascadeGenerator: cascades_per_run reduced to " << cascades_per_run << G4endl;
+  }
+
   InMgr->GetVariable("E_x",E_x);//excited state MeV
 
   end = false;
@@ -19,51 +38,140 @@ CascadeGenerator::CascadeGenerator(InputManager* aInMgr) {
 
   dE = E_x/double(n_bin-1);
 
-  E_array.resize(n_bin);
-  gamma_array.resize(n_gamma);
-  point_array.resize(n_bin-1+n_gamma);
-
   string CascType;
   InMgr->GetVariable("CascType",CascType);
 
   if (CascType == "Custom") custom = GenerateCascadeCustom();
-  if (CascType == "Regular") GenerateCascade();
-  
-  it = gammatot_array.begin();
+  else if (CascType == "Regular") GenerateCascade();
+  else if (CascType == "List") GenerateCascadeList();
+  else if (CascType == "Library") GenerateCascadeLibrary();
+  else {
+    G4cout << "error: " << CascType << " is not a valid CascType" << G4endl;
+    exit(1);
+  }
+
+  if (N_run<first_run) N_run = first_run;
+
+  if (custom == false && GetSweepSize() == 0) end = true;//nothing left to simulate
 
 }
 
 //-------------------------------------------------------------------
-//generates individual cascade for run
+
+CascadeGenerator::~CascadeGenerator() {
+
+  delete CasEnum;
+
+}
+
+//-------------------------------------------------------------------
+//generates individual cascade(s) for run, runs N_run...N_run+n_cascade-1
 void CascadeGenerator::SetCascade() {
 
   if (custom == true) {
+    cascade.clear();
     for (int i=0; i<gammatot_array.size(); i++) {
       cascade.push_back(gammatot_array.at(i));
       G4cout << gammatot_array.at(i) << "\t";
     }
     G4cout << G4endl;
+    n_cascade = 1;
     end = true;
     return;
   }
 
-  if ((N_run)*n_gamma>=gammatot_array.size() || N_run>run_end) {
-   end = true;
-//   G4cout << "END!!" << G4endl;
-//   return;
+  n_cascade = GetSweepSize();
+
+  sweep.clear();
+  sweep.resize(n_cascade);
+
+  if (n_cascade>0 && CasEnum) CasEnum->Unrank(N_run,step);
+
+  for (int j=0; j<n_cascade; j++) {
+
+    G4cout << N_run+j << "\t";
+
+    if (CasEnum == 0) {//"List" or "Library"
+      sweep[j] = list.at(N_run+j-first_run);
+      for (int i=0; i<sweep[j].size(); i++) {
+        G4cout << sweep[j][i] << "\t";
+      }
+      G4cout << G4endl;
+      continue;
+    }
+
+    if (j>0) CasEnum->Next(step);//lazy, rank N_run+j
+
+    for (int i=0; i<n_gamma; i++) {
+      if (step[i]>0) {
+        sweep[j].push_back(dE*step[i]);
+        G4cout << dE*step[i] << "\t";
+      }
+    }
+
+    G4cout << G4endl;
+
   }
 
   cascade.clear();
-  G4cout << N_run << "\t";
+  if (n_cascade>0) cascade = sweep[0];
 
-  for (int i=N_run*n_gamma; i<N_run*n_gamma+n_gamma; i++) {
-    if (gammatot_array.at(i)>0) {
-      cascade.push_back(gammatot_array.at(i));
-      G4cout << gammatot_array.at(i) << "\t";
-    }
+}
+
+//-------------------------------------------------------------------
+//number of cascades the next run will simulate, limited by run_end and
+//the number of cascades available
+
+int CascadeGenerator::GetSweepSize() {
+
+  if (custom == true) return 1;
+
+  int n = cascades_per_run;
+
+  if (N_run+n-1>run_end) n = run_end-N_run+1;
+  if (N_run+n>first_run+n_total) n = first_run+n_total-N_run;
+  if (n<0) n = 0;
+
+  return n;
+
+}
+
+//-------------------------------------------------------------------
+
+void CascadeGenerator::EndOfRun() {
+
+  if (custom == true) {
+    N_run++;
+    return;
   }
 
-  G4cout << G4endl;
+  N_run += n_cascade;
+
+  if (N_run>run_end || N_run>=first_run+n_total) end = true;//all cascades simulated
+
+}
+
+//-------------------------------------------------------------------
+//events are numbered consecutively through the cascades of a run
+
+int CascadeGenerator::GetCascadeIndex(int eventID) {
+
+  int index = eventID/N_events;
+
+  if (index>=n_cascade) index = n_cascade-1;
+  if (index<0) index = 0;
+
+  return index;
+
+}
+
+//-------------------------------------------------------------------
+
+const std::vector<double>& CascadeGenerator::GetCascade(int index) {
+
+  if (custom == true) return cascade;
+
+  return sweep.at(index);
 
 }
 
@@ -76,100 +184,132 @@ std::vector<double> CascadeGenerator::GetCascade() {
 bool CascadeGenerator::GenerateCascadeCustom() {
 
   double Ein;
+  char name[10];
 
-  InMgr->GetVariable("E0",Ein);
-  gammatot_array.push_back(Ein);//MeV
+  for (int i=0; i<n_gamma; i++) {
+    sprintf(name,"E%i",i);
+    InMgr->GetVariable(name,Ein);
+    gammatot_array.push_back(Ein);//MeV
+  }
 
-  InMgr->GetVariable("E1",Ein);
-  gammatot_array.push_back(Ein);//MeV
+  return true;
 
-  InMgr->GetVariable("E2",Ein);
-  gammatot_array.push_back(Ein);//MeV
+}
 
-  InMgr->GetVariable("E3",Ein);
-  gammatot_array.push_back(Ein);//MeV
+//-------------------------------------------------------------------
+//sets up the enumeration of all possible cascades for excited state, E in MeV
+void CascadeGenerator::GenerateCascade() {
 
-  InMgr->GetVariable("E4",Ein);
-  gammatot_array.push_back(Ein);//MeV
+  CasEnum = new CascadeEnumerator(n_gamma,n_bin-1);
+  n_total = CasEnum->Count();
 
-  return true;
+  G4cout << CasEnum->Count() << " cascades of " << E_x << " MeV in steps of " << dE << " MeV" << G4endl;
 
 }
 
 //-------------------------------------------------------------------
-//generates all possible cascades for excited state, E in MeV
-void CascadeGenerator::GenerateCascade() {
-
-  for (int i=0; i<n_bin; i++) {
-    E_array.at(i) = dE*i;
+//reads cascades (one per line, MeV) from CascFile. The gammas of a cascade
+//are emitted independently and isotropically from one vertex, so orderings
+//of the same energies are the same simulation: each multiset is simulated
+//once, as run first_run+k, and alias.dat maps every input line to its run
+void CascadeGenerator::GenerateCascadeList() {
+
+  string CascFile;
+  InMgr->GetVariable("CascFile",CascFile);
+
+  ifstream ifs(CascFile.c_str());
+  if (!ifs.good()) {
+    G4cout << "error: cannot read CascFile " << CascFile << G4endl;
+    exit(1);
   }
 
-  for (int i=0; i<n_gamma; i++) {
-    gamma_array.at(i) = 0;
-  }
+  ofstream alias("alias.dat");
+  alias << "#line\trun\tcanonical cascade (MeV)" << endl;
 
-  for (int i=n_gamma; i<n_bin-1+n_gamma; i++) {
-    point_array.at(i) = 1;
-  }
+  std::map< std::vector<long long>, int > canonical;//energies in eV -> run index
+  string line;
+  int nlines = 0;
+  int nalias = 0;
 
-  for (int i=0; i<n_bin-1+n_gamma; i++) {
+  first_run = 1;
 
-    for (int j=i+1; j<n_bin-1+n_gamma; j++) {
+  while (getline(ifs,line)) {
 
-      for (int k=j+1; k<n_bin-1+n_gamma; k++) {
+    nlines += 1;
+    line = line.substr(0, line.find("#")); // # = comment
 
-        for (int l=k+1; l<n_bin-1+n_gamma; l++) {
+    std::vector<double> energy;
+    stringstream sstr(line);
+    double E;
+    while (sstr >> E) {
+      if (E>0) energy.push_back(E);
+    }
+    if (energy.size() == 0) continue;
 
-          for (int m=l+1; m<n_bin-1+n_gamma; m++) {
+    if (energy.size()>max_gamma) {
+      G4cout << "error: more than " << max_gamma << " gammas at line " << nlines << " of " << CascFile << G4endl;
+      exit(1);
+    }
 
-            for (int a=0; a<n_bin-1+n_gamma; a++) {
-              point_array.at(a) = 1;
-            }
+    std::sort(energy.begin(),energy.end());//canonical order
 
-            point_array.at(i) = 0;
-            point_array.at(j) = 0;
-            point_array.at(k) = 0;
-            point_array.at(l) = 0;
-            point_array.at(m) = 0;
+    std::vector<long long> key;
+    for (int i=0; i<energy.size(); i++) {
+      key.push_back(llround(energy[i]*1.e6));
+    }
 
-            int gamma_count = 0;
-            int decay_count = 0;
-            double E_sum = 0;
-            for (int a=0; a<n_bin-1+n_gamma; a++) {
+    std::map< std::vector<long long>, int >::iterator found = canonical.find(key);
+    int index;
+    if (found == canonical.end()) {
+      index = list.size();
+      canonical[key] = index;
+      list.push_back(energy);
+    }
+    else {
+      index = found->second;
+      nalias += 1;
+    }
 
-              if (point_array.at(a) == 0) {
-                gamma_array.at(decay_count) = E_array.at(gamma_count);
-                E_sum += gamma_array.at(decay_count);
-                decay_count += 1;
-              }
-              if (point_array.at(a) == 1) gamma_count+=1;
+    alias << nlines << "\t" << first_run+index;
+    for (int i=0; i<list[index].size(); i++) {
+      alias << "\t" << list[index][i];
+    }
+    alias << endl;
 
-            }
+  }
 
-            count+=1;
-/*
-            G4cout << count << "\t";
-            for (int a=0; a<n_bin-1+n_gamma; a++) {
-              G4cout << point_array.at(a) << "\t";
-            }
-*/
-            if (E_sum/E_x-1<0.001 && E_sum/E_x-1>-0.001) {
-//              G4cout << G4endl;
-//              G4cout << E_sum << "\t";
-              for (int a=0; a<n_gamma; a++) {
-//                G4cout << gamma_array.at(a) << "\t";
-                gammatot_array.push_back(gamma_array.at(a));
-              }
-            }
-//            G4cout << G4endl;
-          }
+  n_total = list.size();
 
-        }
+  G4cout << n_total << " distinct cascades in " << CascFile << ", " << nalias << " permutations aliased (alias.dat)" << G4endl;
 
-      }
+}
 
-    }
+//-------------------------------------------------------------------
+//single gamma response library: one run per grid energy, run first_run+k
+//has E = lib_E_min + k*lib_dE (MeV). The runs are folded into cascade
+//spectra offline by fold
+void CascadeGenerator::GenerateCascadeLibrary() {
+
+  double E_min, E_max, E_step;
+  InMgr->GetVariable("lib_E_min",E_min);
+  InMgr->GetVariable("lib_E_max",E_max);
+  InMgr->GetVariable("lib_dE",E_step);
+
+  if (E_min<=0 || E_step<=0 || E_max<E_min) {
+    G4cout << "error: the library grid needs 0 < lib_E_min <= lib_E_max and lib_dE > 0" << G4endl;
+    exit(1);
+  }
 
+  first_run = 1;
+
+  int n_grid = int((E_max-E_min)/E_step+1.e-6)+1;
+
+  for (int k=0; k<n_grid; k++) {
+    list.push_back(std::vector<double>(1,E_min+k*E_step));
   }
-//  G4cout << G4endl;
+
+  n_total = list.size();
+
+  G4cout << n_total << " library energies from " << E_min << " to " << E_min+(n_grid-1)*E_step << " MeV" << G4endl;
+
 }
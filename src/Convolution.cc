@@ -0,0 +1,86 @@
+#include "Convolution.hh"
+#include <cmath>
+
+//-------------------------------------------------------------------------
+
+Convolution::Convolution(int an_bin, double min, double max, Digitiser& D, double n_sigma) {
+
+  n_bin = an_bin;
+
+  double width = (max-min)/n_bin;
+
+  lo.resize(n_bin);
+  offset.push_back(0);
+
+  for (int j=0; j<n_bin; j++) {
+
+    double E = min+(j+0.5)*width;//source bin centre
+    double sigma = (E>0) ? D.Sigma(E) : 0.;
+
+    if (sigma<=0) {//no spread
+      lo[j] = j;
+      weight.push_back(1.);
+      offset.push_back(weight.size());
+      continue;
+    }
+
+    int first = int(floor((E-n_sigma*sigma-min)/width));
+    int last = int(floor((E+n_sigma*sigma-min)/width));
+    if (first<0) first = 0;
+    if (last>n_bin-1) last = n_bin-1;
+
+    lo[j] = first;
+
+    for (int i=first; i<=last; i++) {//Gaussian integrated over output bin i
+      double a = (min+i*width-E)/(sqrt(2.)*sigma);
+      double b = (min+(i+1)*width-E)/(sqrt(2.)*sigma);
+      weight.push_back(0.5*(erf(b)-erf(a)));
+    }
+
+    offset.push_back(weight.size());
+
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+Convolution::~Convolution() {
+
+}
+
+//-------------------------------------------------------------------------
+
+void Convolution::Apply(const double* in, double* out) {
+
+  for (int i=0; i<n_bin; i++) {
+    out[i] = 0;
+  }
+
+  for (int j=0; j<n_bin; j++) {
+
+    double c = in[j];
+    if (c==0) continue;
+
+    double* o = out+lo[j];
+    const double* w = &weight[offset[j]];
+    int n = offset[j+1]-offset[j];
+
+    for (int k=0; k<n; k++) {
+      o[k] += c*w[k];
+    }
+
+  }
+
+}
+
+//-------------------------------------------------------------------------
+//e.g. the Etot spectra of every cascade of a sweep with one kernel
+
+void Convolution::Batch(const double* in, double* out, int n_spectrum) {
+
+  for (int s=0; s<n_spectrum; s++) {
+    Apply(in+(long long)s*n_bin,out+(long long)s*n_bin);
+  }
+
+}
@@ -1,14 +1,17 @@
 #include "DAQManager.hh"
+#include <mutex>
+#include "Randomize.hh"
 
 namespace {
-  std::vector<double> E_gamma;//energy of each gamma detected
-  std::vector<int> N_det;//coresponding detector number
+  std::mutex mergeMutex;//guards the master trees and counts, digitiser threads exist in sequential builds too
+  const unsigned int buffer_size = 1000;//worker events per flush to the master tree
 }
 
 //-------------------------------------------------------------------------
 
 DAQManager::DAQManager(InputManager* aInMgr, CascadeGenerator* aCasGen) {
 
+  master = 0;
   InMgr = aInMgr;
   CasGen = aCasGen;
 
@@ -16,8 +19,63 @@ DAQManager::DAQManager(InputManager* aInMgr, CascadeGenerator* aCasGen) {
 //  N_run-=1;
   N_coinc = 0;
   N_event = 0;
+  index = 0;
+  n_acc = 0;
+  run_seed = 0;
+
+  bool async;
+  int queue;
+  InMgr->GetVariable("AsyncWriter",async);
+  InMgr->GetVariable("writer_queue",queue);
+  writer = 0;
+  if (async) writer = new EventWriter(queue);
+
+  int n_digi;
+  InMgr->GetVariable("DigiThreads",n_digi);
+  InMgr->GetVariable("digi_queue",queue);
+  pipeline = 0;
+  if (n_digi>0) pipeline = new DigiPipeline(queue);
+
+  Digi = new Digitiser(InMgr);
+  rng = new TRandom3();
+
+  InMgr->GetVariable("OutputMode",output);
+  InMgr->GetVariable("OutputFile",OutputFile);
+  InMgr->GetVariable("shard_MB",shard_MB);
+  shard = 0;
+  f1 = 0;
+
+  if (output!="PerRun" && output!="Single" && output!="Shard") {
+    G4cout << "error: " << output << " is not a valid OutputMode" << G4endl;
+    exit(1);
+  }
 
-//  h_Etotconv = new TH1F("Etotconv","Etotconv",200,0,20);
+  string DigiFile;
+  InMgr->GetVariable("DigiFile",DigiFile);
+  Digitiser::ReadList(DigiFile,fanout);
+
+  string choice;
+  InMgr->GetVariable("CascType",choice);
+  InMgr->GetVariable("RawTree",raw);
+  InMgr->GetVariable("ThresholdTables",tables);
+  InMgr->GetVariable("SparseMatrices",sparse);
+  bool event_columns;
+  InMgr->GetVariable("EventColumns",event_columns);
+  InMgr->GetVariable("column_level",column_level);
+  if (event_columns == false) column_level = -1;
+  columns = 0;
+  library = (choice=="Library");
+  if (library) raw = true;//the library is read from the Raw tree
+  RawTree = 0;
+
+  bool EtotConv;
+  InMgr->GetVariable("EtotConv",EtotConv);
+  Conv = 0;
+  if (EtotConv) Conv = new Convolution(200,0,20,*Digi);//binning of h_Etot
+
+  for (int t=0; t<n_digi; t++) {//digitiser thread instances, as the workers
+    stages.push_back(new DAQManager(this));
+  }
 
 /*
   ifstream ifs("input.dat");
@@ -32,24 +90,218 @@ DAQManager::DAQManager(InputManager* aInMgr, CascadeGenerator* aCasGen) {
 */
 }
 
+//-------------------------------------------------------------------------
+//worker thread instance: fills the master's histograms directly, events
+//and counts are kept locally and merged at end of run, only the master
+//touches the TFile
+
+DAQManager::DAQManager(DAQManager* amaster) {
+
+  master = amaster;
+  InMgr = master->InMgr;
+  CasGen = master->CasGen;
+
+  N_run = master->N_run;
+  N_coinc = 0;
+  N_event = 0;
+  index = 0;
+  n_acc = 0;
+  run_seed = 0;
+  writer = 0;
+  f1 = 0;
+  Conv = 0;
+  pipeline = 0;
+
+  Digi = new Digitiser(InMgr);
+  rng = new TRandom3();
+  fanout = master->fanout;
+  library = master->library;
+  raw = master->raw;
+  tables = master->tables;
+  sparse = master->sparse;
+  column_level = -1;
+  columns = 0;
+  RawTree = 0;
+
+  event_buffer.reserve(buffer_size);
+
+}
+
 //-------------------------------------------------------------------------
 
 DAQManager::~DAQManager() {
 
 //  f1->Write();
 
+  delete pipeline;//joins the digitiser threads before their instances go
+  for (int t=0; t<stages.size(); t++) {
+    delete stages[t];
+  }
+
+  delete writer;
+  if (master == 0 && f1) CloseFile();//consolidated output stays open between runs
+  delete Digi;
+  delete rng;
+  delete Conv;
+
+  for (int j=0; j<acc.size(); j++) {
+    delete acc[j];
+  }
+
+}
+
+//-------------------------------------------------------------------------
+//results of one cascade, allocated once and reused
+
+DAQManager::Accumulator::Accumulator(int n_fanout, bool library, bool tables, bool addback, bool sparse) {
+
+  h_E    = new Histogram(1500,0,15,10,0,10);
+  h_Etot = new Histogram(200,0,20);
+  h_mult = new Histogram(10,0,10);
+
+  h_cmult = 0;
+  if (addback) h_cmult = new Histogram(10,0,10);
+
+  h_lib = 0;
+  h_libmult = 0;
+  if (library) {
+    h_lib = new Histogram(31,0,31,1500,0,15);
+    h_libmult = new Histogram(32,0,32);
+  }
+
+  h_E0Mult = 0;
+  h_E0E1 = 0;
+  if (tables) {//fine E0 bins, thresholds are resolved to a bin edge
+    h_E0Mult = new Histogram(1500,0,15,32,0,32);
+    h_E0E1 = new Histogram(300,0,15,300,0,15);
+  }
+
+  s_E0E1 = 0;
+  s_gg = 0;
+  if (sparse) {
+    s_E0E1 = new SparseMatrix();
+    s_gg = new SparseMatrix();
+  }
+
+  for (int d=0; d<n_fanout; d++) {
+    f_E.push_back(new Histogram(1500,0,15,10,0,10));
+    f_Etot.push_back(new Histogram(200,0,20));
+    f_mult.push_back(new Histogram(10,0,10));
+  }
+
+  N_event = 0;
+  N_coinc = 0;
+
+}
+
+DAQManager::Accumulator::~Accumulator() {
+
+  delete h_E;
+  delete h_Etot;
+  delete h_mult;
+  delete h_cmult;
+  delete h_lib;
+  delete h_libmult;
+  delete h_E0Mult;
+  delete h_E0E1;
+  delete s_E0E1;
+  delete s_gg;
+
+  for (int d=0; d<f_E.size(); d++) {
+    delete f_E[d];
+    delete f_Etot[d];
+    delete f_mult[d];
+  }
+
+}
+
+void DAQManager::Accumulator::Reset() {
+
+  h_E->Reset();
+  h_Etot->Reset();
+  h_mult->Reset();
+  if (h_cmult) h_cmult->Reset();
+  if (h_lib) h_lib->Reset();
+  if (h_libmult) h_libmult->Reset();
+  if (h_E0Mult) h_E0Mult->Reset();
+  if (h_E0E1) h_E0E1->Reset();
+  if (s_E0E1) s_E0E1->Clear();
+  if (s_gg) s_gg->Clear();
+
+  for (int d=0; d<f_E.size(); d++) {
+    f_E[d]->Reset();
+    f_Etot[d]->Reset();
+    f_mult[d]->Reset();
+  }
+
+  N_event = 0;
+  N_coinc = 0;
+
+}
+
+//-------------------------------------------------------------------------
+//readies the histograms of the cascade runs N_run...N_run+n_cascade-1, the
+//pool only grows when a run has more cascades than any before
+
+void DAQManager::Book(int n_cascade) {
+
+  while (acc.size()<n_cascade) {
+    acc.push_back(new Accumulator(fanout.size(),library,tables,Digi->GetAddback(),sparse));
+  }
+
+  for (int i=0; i<n_cascade; i++) {
+    acc[i]->Reset();
+  }
+
+  n_acc = n_cascade;
+
 }
 
 //-------------------------------------------------------------------------
 
 void DAQManager::StartOfRun() {
 
-  char FileName[30];
+  index = 0;
+
+  if (master == 0) {//before the worker seeds are drawn, so the run is reproducible from run_seed
+    run_seed = Long64_t(G4UniformRand()*2147483646.)+1;
+    CLHEP::HepRandom::setTheSeed(run_seed);
+  }
+
+  rng->SetSeed(UInt_t(G4UniformRand()*4294967295.)|1);//from this thread's Geant4 engine, 0 is reserved
+
+  Count zero = {0,0};
+  count.assign(CasGen->GetNCascades(),zero);
+
+  if (sparse) {
+    s_E0E1.resize(CasGen->GetNCascades());
+    s_gg.resize(CasGen->GetNCascades());
+  }
+
+  if (master) {//worker: fills the master's histograms, booked before the workers start
+    N_run = master->N_run;
+    return;
+  }
+
+  N_run = CasGen->GetRun();//first cascade of this run
+
+  int n_cascade = CasGen->GetNCascades();
+
+  char FileName[100];
   string choice;
 
   InMgr->GetVariable("CascType",choice);
 
-  if (choice=="Regular") {
+  if (output=="Single") {
+    sprintf(FileName,"%s.root", OutputFile.c_str());
+  }
+  else if (output=="Shard") {
+    sprintf(FileName,"%s_%i.root", OutputFile.c_str(), shard);
+  }
+  else if ((choice=="Regular" || choice=="List" || choice=="Library") && n_cascade>1) {
+    sprintf(FileName,"Run_%i-%i.root", N_run, N_run+n_cascade-1);
+  }
+  else if (choice=="Regular" || choice=="List" || choice=="Library") {
     sprintf(FileName,"Run_%i.root", N_run);
   }
   else if (choice=="Custom") {
@@ -60,24 +312,34 @@ void DAQManager::StartOfRun() {
     exit(1);
   }
 
-  f1 = new TFile(FileName,"RECREATE");
+  if (Digi->GetAddback() && Addback::IsBuilt() == false) {
+    G4cout << "error: Addback needs the crystal positions of the geometry" << G4endl;
+    exit(1);
+  }
 
-  EventTree = new TTree("Event", "Event");
-  RunTree = new TTree("Run", "Run");
-  EventBranch = EventTree->Branch("Events", &data_event, "sum/F:esort[10]:ecal[30]:Mult/I");
-  RunBranch   = RunTree->Branch("Run", &data_run, "Event/I:Run/I:cascade[5]/F");
+  if (output=="PerRun") OpenFile(FileName,n_cascade>1);
+  else if (f1==0) OpenFile(FileName,true);//first run of this file
 
-  for (int j=0; j<5; j++) {
-    data_run.cascade[j] = 0;
-  }
+  f1->cd();//histograms are written with the trees
+  segments.Start(EventTree->GetEntries());
 
-  char name[30];
-  sprintf(name,"E_%i", N_run);
-  h_E    = new TH2F(name,name,1500,0,15,10,0,10);
-  sprintf(name,"Etot_%i", N_run);
-  h_Etot = new TH1F(name,name,200,0,20);
-  sprintf(name,"Mult_%i", N_run);
-  h_mult = new TH1F(name,name,10,0,10);
+  Book(n_cascade);
+
+  if (writer) writer->Start(EventTree,RawTree,columns,&segments);
+
+  if (pipeline) {
+
+    for (int t=0; t<stages.size(); t++) {
+      stages[t]->StartOfRun();//seeded from the master engine
+    }
+
+    pipeline->Start(stages.size(),[this](int t, const DigiPipeline::Deposit* batch, int n) {
+      for (int i=0; i<n; i++) {
+        stages[t]->Process(batch[i].index,batch[i].raw);
+      }
+    });
+
+  }
 
 }
 
@@ -85,169 +347,431 @@ void DAQManager::StartOfRun() {
 
 void DAQManager::EndOfRun() {
 
-  data_run.Event = N_event;
-
-  eff = double(N_coinc)/double(N_event);
-
-  N_event = 0;
-  N_coinc = 0;
+  if (master) {
+    MergeRun();
+    return;
+  }
 
 //  MultLikelihood();
 //  EtotLikelihood();
 
-  data_run.Run = N_run;
+  if (pipeline) {//transport is over, digitise what is left and merge it
+    pipeline->Stop();
+    for (int t=0; t<stages.size(); t++) {
+      stages[t]->MergeRun();
+    }
+  }
+
+  if (writer) writer->Stop();//all events are in the queue once the workers have merged
+
+  for (int j=0; j<n_acc; j++) {
+    acc[j]->N_event += count[j].N_event;
+    acc[j]->N_coinc += count[j].N_coinc;
+    if (sparse) {
+      acc[j]->s_E0E1->Merge(s_E0E1[j]);
+      acc[j]->s_gg->Merge(s_gg[j]);
+    }
+  }
+
+  for (int j=0; j<n_acc; j++) {//one Run entry per cascade
+
+    data_run.Event = acc[j]->N_event;
+    data_run.Run = N_run+j;
+
+    eff = double(acc[j]->N_coinc)/double(acc[j]->N_event);
+
+    for (int i=0; i<max_gamma; i++) {
+      data_run.cascade[i] = 0;
+    }
+
+    const std::vector<double>& cascade = CasGen->GetCascade(j);
+    std::vector<double>::const_iterator it;
+
+    int i=0;
 
-  std::vector<double> cascade = CasGen->GetCascade();
-  std::vector<double>::iterator it;
+    for (it=cascade.begin(); it!=cascade.end(); it++) {
+      data_run.cascade[i] = *it;
+      i++;
+    }
 
-  int i=0;
+    RunTree->Fill();
 
-  for (it=cascade.begin(); it!=cascade.end(); it++) {
-    data_run.cascade[i] = *it;
-    i++;
   }
 
-  RunTree->Fill();
+  if (sparse) WriteSparse();
 
-  f1->Write();
+  if (output!="PerRun") {
 
-  delete EventTree;
-  delete RunTree;
+    ofstream idx((OutputFile+".index").c_str(),ios::app);
 
-  delete h_E;
-  delete h_Etot;
-  delete h_mult;
+    std::vector<RunSegments::Segment> list = segments.Sorted();
+
+    for (int j=0; j<list.size(); j++) {//one row per stretch, a run may have several
+      index_run.Run = list[j].run;
+      index_run.Shard = shard;
+      index_run.First = list[j].first;
+      index_run.Entries = list[j].entries;
+      IndexTree->Fill();
+      idx << index_run.Run << "\t" << f1->GetName() << "\t" << index_run.First << "\t" << index_run.Entries << endl;
+    }
+
+  }
 
-  N_run += 1;
+  std::vector<TH1*> written = Write();//ROOT histograms only exist for the write
 
-/*
-  float energy[200];
-  float counts[200];
+  f1->Write(0,TObject::kOverwrite);//consolidated: only the latest tree headers are kept
 
-  for (int i=1; i<= h_Etot->GetNbinsX(); i++) {
-    energy[i] = 0.1*double(i);
-    counts[i] = h_Etot->GetBinContent(i);
+  for (int j=0; j<written.size(); j++) {
+    delete written[j];
   }
 
-  for (int j=2; j<= h_Etot->GetNbinsX(); j++) {
-    h_Etotconv->SetBinContent(j,gaus(energy,counts,j-1));
+  if (output=="PerRun" || (output=="Shard" && f1->GetSize()>shard_MB*1.e6)) {
+    CloseFile();
+    if (output=="Shard") shard += 1;
   }
-*/
+
+  N_event = 0;
+  N_coinc = 0;
+
 }
 
 //-------------------------------------------------------------------------
-//detector convolution
-float DAQManager::gaus(float energy[200], float counts[200], int j) {
+//creates the output trees; sweep = the Event tree has a Run branch. A
+//consolidated file also gets the RunIndex tree (run -> Event entry range)
+
+void DAQManager::OpenFile(const char* FileName, bool sweep) {
+
+  f1 = new TFile(FileName,"RECREATE");
+
+  EventTree = new TTree("Event", "Event");
+  RunTree = new TTree("Run", "Run");
+  EventBranch = EventTree->Branch("Events", &data_event, "sum/F:esort[10]:ecal[30]:Mult/I");
+  RunBranch   = RunTree->Branch("Run", &data_run, "Event/I:Run/I:cascade[10]/F");
+  EventTree->Branch("Cluster", &data_event.Cluster, "Cluster/I");//separate, older readers know Events only
+  RunTree->Branch("Seed", &run_seed, "Seed/L");//same for all cascades of a sweep
 
-  float factor = sqrt(8.0*log(2.0));
-  float k = 0.1733;
-  float pi = 3.14159265;
-  float sigma = (k*sqrt(energy[j]))/factor;
-  float calcGaus[200];
-  float sum=0.0;
+  Addback::Write();//neighbour masks, for replays with addback
 
-  for (int i=0; i<200; i++){
-    calcGaus[i] = 0;
+  if (sweep) {
+    EventTree->Branch("Run", &event_run, "Run/I");//cascade run number of each event
   }
 
-  for (int i=0; i<200; i++){
-    calcGaus[i]=(0.084/(sqrt(2*pi*sigma*sigma)))*(exp(-((energy[i]-energy[j])*(energy[i]-energy[j]))/(2*sigma*sigma)));
+  RawTree = 0;
+  if (raw) {
+    RawTree = new TTree("Raw", "Raw");
+    RawTree->Branch("Run", &raw_event.Run, "Run/I");
+    RawTree->Branch("n", &raw_event.n, "n/I");
+    RawTree->Branch("det", raw_event.det, "det[n]/I");
+    RawTree->Branch("dep", raw_event.dep, "dep[n]/F");
   }
 
-  for (int i=0; i<200; i++){
-    sum = sum + calcGaus[i]*counts[i];
+  SparseTree = 0;
+  if (sparse) {//addresses are set per matrix, WriteSparse
+    SparseTree = new TTree("Sparse", "Sparse");
+    SparseTree->Branch("Run", &data_sparse.Run, "Run/I");
+    SparseTree->Branch("Matrix", &data_sparse.Matrix, "Matrix/I");
+    SparseTree->Branch("Rows", &data_sparse.Rows, "Rows/I");
+    SparseTree->Branch("nnz", &data_sparse.nnz, "nnz/I");
+    row_ptr.assign(sparse_bins+1,0);
+    col.resize(1);
+    val.resize(1);
+    SparseTree->Branch("row_ptr", &row_ptr[0], "row_ptr[Rows]/I");
+    SparseTree->Branch("col", &col[0], "col[nnz]/s");
+    SparseTree->Branch("val", &val[0], "val[nnz]/i");
   }
 
-  G4cout << j << "\t" << sum << G4endl;
+  if (column_level>=0) {//same name, .col, row i = Event entry i
+    string ColName = FileName;
+    if (ColName.size()>5 && ColName.substr(ColName.size()-5)==".root") ColName.resize(ColName.size()-5);
+    columns = new ColumnWriter();
+    if (columns->Create(ColName+".col",column_level) == false) exit(1);
+  }
+
+  IndexTree = 0;
+  if (output!="PerRun") {
+    IndexTree = new TTree("RunIndex", "RunIndex");
+    IndexTree->Branch("Run", &index_run.Run, "Run/I");
+    IndexTree->Branch("Shard", &index_run.Shard, "Shard/I");
+    IndexTree->Branch("First", &index_run.First, "First/L");
+    IndexTree->Branch("Entries", &index_run.Entries, "Entries/L");
+  }
 
-  return sum;
+  if (output!="PerRun" && shard==0) {//new text index of all shards
+    ofstream idx((OutputFile+".index").c_str());
+    idx << "#run\tfile\tfirst\tentries" << endl;
+  }
 
 }
 
 //-------------------------------------------------------------------------
 
-void DAQManager::StartOfEvent() {
+void DAQManager::CloseFile() {
 
-  N_event+=1;
+  f1->Write(0,TObject::kOverwrite);
 
-  data_event.sum = -1;
-  data_event.Mult = -1;
+  delete EventTree;
+  delete RunTree;
+  delete RawTree;
+  delete IndexTree;
+  delete SparseTree;
+  if (columns) columns->Finish();
+  delete columns;
+  columns = 0;
+  RawTree = 0;
+  IndexTree = 0;
+  SparseTree = 0;
+
+  delete f1;
+  f1 = 0;
 
 }
 
 //-------------------------------------------------------------------------
+//adds this worker's run into the master, called before the master EndOfRun
+
+void DAQManager::MergeRun() {
+
+  FlushEvents();
+
+  std::lock_guard<std::mutex> lock(mergeMutex);
+
+  for (int j=0; j<count.size(); j++) {
+    master->acc[j]->N_event += count[j].N_event;
+    master->acc[j]->N_coinc += count[j].N_coinc;
+  }
+
+  for (int j=0; j<s_E0E1.size(); j++) {//empties this thread's matrices
+    master->acc[j]->s_E0E1->Merge(s_E0E1[j]);
+    master->acc[j]->s_gg->Merge(s_gg[j]);
+  }
+
+  count.clear();
+
+  N_event = 0;
+  N_coinc = 0;
 
-bool Decend (double i,double j) {
-  return (i>j);//used to sort gamma enery array
 }
 
 //-------------------------------------------------------------------------
+//one Sparse entry per cascade and matrix, after the Run entries
 
-void DAQManager::EndOfEvent() {
+void DAQManager::WriteSparse() {
 
-  double Etot=0;
+  for (int j=0; j<n_acc; j++) {
+    for (int m=0; m<2; m++) {
+
+      SparseMatrix* s = (m==0) ? acc[j]->s_E0E1 : acc[j]->s_gg;
+      s->ToCSR(row_ptr,col,val);
+
+      data_sparse.Run = N_run+j;
+      data_sparse.Matrix = m;
+      data_sparse.Rows = row_ptr.size();
+      data_sparse.nnz = col.size();
 
-  for (int i=0; i<10; i++) {
-    data_event.esort[i] = -1;
+      if (col.size()==0) {//the branches need an address
+        col.resize(1);
+        val.resize(1);
+      }
+
+      SparseTree->SetBranchAddress("row_ptr",&row_ptr[0]);
+      SparseTree->SetBranchAddress("col",&col[0]);
+      SparseTree->SetBranchAddress("val",&val[0]);
+      SparseTree->Fill();
+
+    }
+    acc[j]->s_E0E1->Clear();//memory back between runs, the histograms stay
+    acc[j]->s_gg->Clear();
   }
 
-  for (int i=0; i<30; i++) {
-    data_event.ecal[i] = -1;
+}
+
+//-------------------------------------------------------------------------
+
+void DAQManager::FillEvent() {
+
+  event_run = N_run+index;
+
+  raw_event.Run = event_run;
+
+  EventWriter* w = master ? master->writer : writer;
+
+  if (w) {
+    w->Push(data_event,event_run,raw ? &raw_event : 0);
+    return;
   }
 
-  if (E_gamma.size() == 0) {
-    data_event.sum = -1;
+  if (master == 0) {
+    std::lock_guard<std::mutex> lock(mergeMutex);//digitiser threads flush into the same trees
     EventTree->Fill();
+    if (raw) RawTree->Fill();
+    if (columns) columns->Fill(data_event,event_run);
+    segments.Add(event_run);
     return;
   }
 
-  std::vector<double> E_orig = E_gamma;//unsorted energy array
-  std::sort(E_gamma.begin(),E_gamma.end(),Decend);//sort energy array in decending order
+  event_buffer.push_back(Buffered());
+  event_buffer.back().data = data_event;
+  event_buffer.back().run = event_run;
+  if (raw) event_buffer.back().raw = raw_event;
+  if (event_buffer.size() >= buffer_size) FlushEvents();
 
-  std::vector<double>::iterator it;//gamma E
-  std::vector<int>::iterator it2;//det number
-  it=E_gamma.begin();//E0, MeV
-  it2=N_det.begin();
+}
 
-  if (*it>0.0) {//if E0 above 0 regester event as coincidence
-    N_coinc += 1;
+//-------------------------------------------------------------------------
+//copies buffered worker events into the master Event tree
 
-//    G4cout << "coincidence!!" << "\t";//verbosity == high
+void DAQManager::FlushEvents() {
 
-    mult = E_gamma.size();//multiplicity
-    h_mult->Fill(mult-1,1.);
-    data_event.Mult = mult;
+  if (event_buffer.size() == 0) return;
 
-    for (int i=0; it!=E_gamma.end(); it++) {
-      h_E->Fill(*it,i,1.);
-      data_event.esort[i] = *it;
-      Etot+=*it;
-      i++;
-//      G4cout << data_event.esort[i] << G4endl;
+  std::lock_guard<std::mutex> lock(mergeMutex);
+
+  for (unsigned int i=0; i<event_buffer.size(); i++) {
+    master->data_event = event_buffer[i].data;
+    master->event_run = event_buffer[i].run;
+    master->EventTree->Fill();
+    if (master->columns) master->columns->Fill(event_buffer[i].data,event_buffer[i].run);
+    master->segments.Add(event_buffer[i].run);
+    if (raw) {
+      master->raw_event = event_buffer[i].raw;
+      master->RawTree->Fill();
     }
+  }
+
+  event_buffer.clear();
+
+}
+
+//-------------------------------------------------------------------------
+
+void DAQManager::StartOfEvent(int eventID) {
+
+  index = CasGen->GetCascadeIndex(eventID);
+
+  N_event+=1;
+  count[index].N_event+=1;
+
+}
+
+//-------------------------------------------------------------------------
 
-    for (int i=0; i<E_orig.size(); i++) {
-//      G4cout << N_det.at(i) << "\t" << E_orig.at(i) << G4endl;
-      int detnum = N_det.at(i)-1;//numbering scheme as of August 2014
-      data_event.ecal[detnum]=E_orig.at(i);
+void DAQManager::EndOfEvent() {
+
+  raw_event.Run = N_run+index;
+  raw_event.n = 0;
+  for (int i=0; i<E_gamma.size() && i<max_crys; i++) {
+    raw_event.det[i] = N_det[i];
+    raw_event.dep[i] = E_gamma[i];
+    raw_event.n += 1;
+  }
+
+  E_gamma.clear();
+  N_det.clear();
+
+  DigiPipeline* p = master ? master->pipeline : pipeline;
+
+  if (p) {
+    p->Publish(index,raw_event);//a digitiser thread takes it from here
+    return;
+  }
+
+  Process(index,raw_event);
+
+}
+
+//-------------------------------------------------------------------------
+//DAQ chain of one event, on the transport thread or on a digitiser thread
+
+void DAQManager::Process(int event_index, const Raw_Event& deposit) {
+
+  index = event_index;
+
+  if (&deposit != &raw_event) raw_event = deposit;
+
+  E_gamma.clear();
+  N_det.clear();
+  for (int i=0; i<raw_event.n; i++) {
+    N_det.push_back(raw_event.det[i]);
+    E_gamma.push_back(raw_event.dep[i]);
+  }
+
+  data_event.sum = -1;
+  data_event.Mult = -1;
+
+  Accumulator& a = *(master ? master->acc[index] : acc[index]);//shared by all threads
+
+  if (library) {//raw single-gamma response
+    for (int i=0; i<E_gamma.size(); i++) {
+      a.h_lib->Fill(N_det[i],E_gamma[i]);
     }
+    a.h_libmult->Fill(E_gamma.size());
+  }
 
-    h_Etot->Fill(Etot,1.);
-    data_event.sum = Etot;
+  if (Digitise(*Digi,data_event,a.h_E,a.h_Etot,a.h_mult)) {//if E0 above threshold regester event as coincidence
+    N_coinc += 1;
+    count[index].N_coinc += 1;
+    if (a.h_cmult) a.h_cmult->Fill(data_event.Cluster-1);
+    if (tables) {
+      a.h_E0Mult->Fill(E_sort[0],data_event.Mult);//crystals, as Mult_ (E_sort holds clusters with addback)
+      a.h_E0E1->Fill(E_sort[0],E_sort.size()>1 ? E_sort[1] : -1.);//single crystal: E1 underflow, -1 as Digitiser::Clear
+    }
+    if (sparse) {//thread local, no atomics on the 1500x1500 grid
+      int b[max_crys];
+      int n = 0;
+      for (int i=0; i<E_sort.size() && n<max_crys; i++) {
+        b[n++] = SparseMatrix::Bin(E_sort[i]);
+      }
+      if (n>1 && b[0]>=0 && b[1]>=0) s_E0E1[index].Add(b[0],b[1]);
+      for (int i=0; i<n; i++) {
+        for (int j=i+1; j<n; j++) {
+          if (b[i]>=0 && b[j]>=0) s_gg[index].Add(b[i],b[j]);
+        }
+      }
+    }
+//    G4cout << "coincidence!!" << "\t";//verbosity == high
+  }
 
+  for (int d=0; d<fanout.size(); d++) {//same hits through each fan-out config
+    Digitise(fanout[d],fan_event,a.f_E[d],a.f_Etot[d],a.f_mult[d]);
   }
 
  //verbosity == high
 /*  G4cout << E_gamma.size() << "\t";
-  for (it=E_gamma.begin(); it!=E_gamma.end(); it++) {
-    G4cout << *it << "\t";
+  for (int i=0; i<E_gamma.size(); i++) {
+    G4cout << E_gamma[i] << "\t";
   }
   G4cout << G4endl;
 */
   E_gamma.clear();
   N_det.clear();
 
-  EventTree->Fill();
+  FillEvent();
+
+}
+
+//-------------------------------------------------------------------------
+//digitises the raw hits of this event with D and fills its histograms,
+//returns true for a coincidence
+
+bool DAQManager::Digitise(Digitiser& D, Data_Event& event, Histogram* h_E, Histogram* h_Etot, Histogram* h_mult) {
+
+  D.Digitise(E_gamma,N_det,E_digi,N_digi,rng);
+
+  if (D.Build(E_digi,N_digi,event,E_sort) == false) return false;
+
+  mult = event.Mult;//crystals, E_sort holds the clusters with addback
+  h_mult->Fill(mult-1);
+
+  double Etot=0;
+
+  for (int i=0; i<E_sort.size(); i++) {
+    h_E->Fill(E_sort[i],i);
+    Etot+=E_sort[i];
+  }
+
+  h_Etot->Fill(Etot);
+
+  return true;
 
 }
 
@@ -262,12 +786,68 @@ void DAQManager::SetDetNum(int n) {
 }
 
 //-------------------------------------------------------------------------
+//converts this run's histograms to ROOT ones in the current directory
+
+std::vector<TH1*> DAQManager::Write() {
 
-void DAQManager::Write() {
+  std::vector<TH1*> h;
+  char name[30];
+
+  for (int j=0; j<n_acc; j++) {
+
+    sprintf(name,"E_%i", N_run+j);
+    h.push_back(acc[j]->h_E->ToTH2F(name));
+    sprintf(name,"Etot_%i", N_run+j);
+    h.push_back(acc[j]->h_Etot->ToTH1F(name));
+    sprintf(name,"Mult_%i", N_run+j);
+    h.push_back(acc[j]->h_mult->ToTH1F(name));
+
+    if (acc[j]->h_cmult) {
+      sprintf(name,"ClusterMult_%i", N_run+j);
+      h.push_back(acc[j]->h_cmult->ToTH1F(name));
+    }
+
+    if (Conv) {//detector response folded into the Etot spectrum
+      double in[200], out[200];
+      for (int i=0; i<200; i++) {
+        in[i] = acc[j]->h_Etot->GetBinContent(i+1);
+      }
+      Conv->Apply(in,out);
+      sprintf(name,"Etotconv_%i", N_run+j);
+      TH1F* h_Etotconv = new TH1F(name,name,200,0,20);
+      for (int i=0; i<200; i++) {
+        h_Etotconv->SetBinContent(i+1,out[i]);
+      }
+      h.push_back(h_Etotconv);
+    }
+
+    for (int d=0; d<fanout.size(); d++) {
+      string suffix = "_" + fanout[d].GetName();
+      sprintf(name,"E_%i", N_run+j);
+      h.push_back(acc[j]->f_E[d]->ToTH2F((name+suffix).c_str()));
+      sprintf(name,"Etot_%i", N_run+j);
+      h.push_back(acc[j]->f_Etot[d]->ToTH1F((name+suffix).c_str()));
+      sprintf(name,"Mult_%i", N_run+j);
+      h.push_back(acc[j]->f_mult[d]->ToTH1F((name+suffix).c_str()));
+    }
+
+    if (tables) {
+      sprintf(name,"E0Mult_%i", N_run+j);
+      h.push_back(acc[j]->h_E0Mult->ToTH2F(name));
+      sprintf(name,"E0E1_%i", N_run+j);
+      h.push_back(acc[j]->h_E0E1->ToTH2F(name));
+    }
+
+    if (library) {
+      sprintf(name,"Lib_%i", N_run+j);
+      h.push_back(acc[j]->h_lib->ToTH2F(name));
+      sprintf(name,"LibMult_%i", N_run+j);
+      h.push_back(acc[j]->h_libmult->ToTH1F(name));
+    }
+
+  }
 
-  h_E->Write();
-  h_Etot->Write();
-  h_mult->Write();
+  return h;
 
 }
 
@@ -1,4 +1,7 @@
 #include "DetectorConstruction.hh"
+#include "G4RunManager.hh"
+#include "G4Version.hh"
+#include "EventAction.hh"
 
 namespace {
 
@@ -45,15 +48,17 @@ DetectorConstruction::~DetectorConstruction() {
 
 G4VPhysicalVolume* DetectorConstruction::Construct() {
 //DefineMaterials();
-return ConstructDetector();
+G4VPhysicalVolume* expHall_phys = ConstructDetector();
+#if G4VERSION_NUMBER<1000
+ConstructSDandField();//Geant4 9.x does not call it
+#endif
+return expHall_phys;
 }
 
 //-------------------------
 
 G4VPhysicalVolume* DetectorConstruction::ConstructDetector() {
 
-  G4SDManager* SDman = G4SDManager::GetSDMpointer();
-
 //------------------------------------------------------ materials
 
   G4NistManager* man = G4NistManager::Instance();
@@ -192,7 +197,7 @@ G4VPhysicalVolume* DetectorConstruction::ConstructDetector() {
 
   G4Polyhedra* crys1 = new G4Polyhedra("crys1",0,360*deg,6,2,zplane,rin,rout); 
                         	
-  G4LogicalVolume* crys1_log = new G4LogicalVolume(crys1,BGO,"crys1_log");
+  crys1_log = new G4LogicalVolume(crys1,BGO,"crys1_log");
 
   G4VisAttributes* crysVisAtt = new G4VisAttributes(G4Colour(1.,0.,0.));
   crysVisAtt->SetForceWireframe(true);
@@ -207,10 +212,18 @@ G4VPhysicalVolume* DetectorConstruction::ConstructDetector() {
   if (GeomType == "Regular") ConstructRegular();//geometry type
   if (GeomType == "Single") Single();
 
-  G4String SDname = "SD";
-  TrackerSD* aTrackerSD = new TrackerSD("BGO",DAQMgr,InMgr);
-  SDman->AddNewDetector(aTrackerSD);
-  crys1_log->SetSensitiveDetector(aTrackerSD);
+//crystal neighbours for addback, from the case placements
+
+  for (int i=0; i<expHall_log->GetNoDaughters(); i++) {
+    G4VPhysicalVolume* pv = expHall_log->GetDaughter(i);
+    if (pv->GetLogicalVolume() != case1_log) continue;
+    G4ThreeVector p = pv->GetTranslation();
+    Addback::SetPosition(pv->GetCopyNo(),p.x()/cm,p.y()/cm,p.z()/cm);
+  }
+
+  double addback_dist;
+  InMgr->GetVariable("addback_dist",addback_dist);
+  Addback::Build(addback_dist);
 
 //place physical volumes
   G4VPhysicalVolume* ref1_phys = new G4PVPlacement(0,G4ThreeVector(0,0,0),ref1_log,"MgO",case1_log,false,0);
@@ -222,6 +235,30 @@ G4VPhysicalVolume* DetectorConstruction::ConstructDetector() {
 
 }
 
+//-------------------------
+//called on every worker thread (and once in sequential mode) after the user
+//actions are built, so the SD can feed that thread's DAQManager; from
+//Construct with Geant4 9.x
+
+void DetectorConstruction::ConstructSDandField() {
+
+  DAQManager* aDAQMgr = DAQMgr;
+
+  const EventAction* event_action = static_cast<const EventAction*>(G4RunManager::GetRunManager()->GetUserEventAction());
+  if (event_action) aDAQMgr = event_action->GetDAQManager();
+
+  G4SDManager* SDman = G4SDManager::GetSDMpointer();
+
+  TrackerSD* aTrackerSD = new TrackerSD("BGO",aDAQMgr,InMgr);
+  SDman->AddNewDetector(aTrackerSD);
+  #if G4VERSION_NUMBER>=1000
+  SetSensitiveDetector(crys1_log,aTrackerSD);
+  #else
+  crys1_log->SetSensitiveDetector(aTrackerSD);
+  #endif
+
+}
+
 //---------------------------------------------------------------------------------
 //---------------------------------------------------------------------------------
 
@@ -0,0 +1,204 @@
+#include "DigiPipeline.hh"
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+namespace {
+  const int batch_size = 256;//records a digitiser thread takes at once
+}
+
+//-------------------------------------------------------------------------
+
+DigiPipeline::DigiPipeline(int size) {
+
+  size_t n = 2;
+  while (n<size) n *= 2;
+
+  cells = new Cell[n];
+  mask = n-1;
+
+  for (size_t i=0; i<n; i++) {
+    cells[i].seq.store(i,memory_order_relaxed);
+  }
+
+  head.store(0);
+  tail.store(0);
+  stop.store(false);
+  published.store(0);
+  stalls.store(0);
+  batches.store(0);
+
+}
+
+//-------------------------------------------------------------------------
+
+DigiPipeline::~DigiPipeline() {
+
+  Stop();
+  delete[] cells;
+
+}
+
+//-------------------------------------------------------------------------
+//stage(t,batch,n) is called on digitiser thread t only, it may keep
+//per-thread state indexed by t
+
+void DigiPipeline::Start(int n_thread, Stage astage) {
+
+  Stop();
+
+  stage = astage;
+  published.store(0);
+  stalls.store(0);
+  batches.store(0);
+  stop.store(false);
+
+  for (int t=0; t<n_thread; t++) {
+    threads.push_back(std::thread(&DigiPipeline::Loop,this,t));
+  }
+
+}
+
+//-------------------------------------------------------------------------
+//same ring as EventWriter (after D. Vyukov), seq == pos means free for the
+//publish at pos, seq == pos+1 means filled for the take at pos
+
+bool DigiPipeline::TryPublish(int index, const Raw_Event& raw) {
+
+  size_t pos = head.load(memory_order_relaxed);
+
+  while (true) {
+
+    Cell& c = cells[pos & mask];
+    size_t seq = c.seq.load(memory_order_acquire);
+    long long dif = (long long)seq - (long long)pos;
+
+    if (dif == 0) {
+      if (head.compare_exchange_weak(pos,pos+1,memory_order_relaxed)) {
+        c.dep.index = index;
+        c.dep.raw.Run = raw.Run;
+        c.dep.raw.n = raw.n;
+        for (int i=0; i<raw.n; i++) {//only the fired crystals
+          c.dep.raw.det[i] = raw.det[i];
+          c.dep.raw.dep[i] = raw.dep[i];
+        }
+        c.seq.store(pos+1,memory_order_release);
+        published.fetch_add(1,memory_order_relaxed);
+        return true;
+      }
+    }
+    else if (dif < 0) {
+      return false;//full
+    }
+    else {
+      pos = head.load(memory_order_relaxed);
+    }
+
+  }
+
+}
+
+//-------------------------------------------------------------------------
+//back-pressure: waits while the digitiser threads are behind
+
+void DigiPipeline::Publish(int index, const Raw_Event& raw) {
+
+  if (TryPublish(index,raw)) return;
+
+  stalls.fetch_add(1,memory_order_relaxed);
+
+  while (TryPublish(index,raw) == false) {
+    std::this_thread::yield();
+  }
+
+}
+
+//-------------------------------------------------------------------------
+//several digitiser threads take, so the tail is claimed with a CAS too
+
+bool DigiPipeline::TryPop(Deposit& dep) {
+
+  size_t pos = tail.load(memory_order_relaxed);
+
+  while (true) {
+
+    Cell& c = cells[pos & mask];
+    size_t seq = c.seq.load(memory_order_acquire);
+    long long dif = (long long)seq - (long long)(pos+1);
+
+    if (dif == 0) {
+      if (tail.compare_exchange_weak(pos,pos+1,memory_order_relaxed)) {
+        dep.index = c.dep.index;
+        dep.raw.Run = c.dep.raw.Run;
+        dep.raw.n = c.dep.raw.n;
+        for (int i=0; i<dep.raw.n; i++) {
+          dep.raw.det[i] = c.dep.raw.det[i];
+          dep.raw.dep[i] = c.dep.raw.dep[i];
+        }
+        c.seq.store(pos+mask+1,memory_order_release);
+        return true;
+      }
+    }
+    else if (dif < 0) {
+      return false;//empty
+    }
+    else {
+      pos = tail.load(memory_order_relaxed);
+    }
+
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+void DigiPipeline::Loop(int thread) {
+
+  std::vector<Deposit> batch(batch_size);
+
+  while (true) {
+
+    int n = 0;
+    while (n<batch_size && TryPop(batch[n])) n++;
+
+    if (n>0) {
+      stage(thread,&batch[0],n);
+      batches.fetch_add(1,memory_order_relaxed);
+      continue;
+    }
+
+    if (stop.load(memory_order_acquire)) {
+      if (TryPop(batch[0]) == false) break;//drained
+      stage(thread,&batch[0],1);
+      continue;
+    }
+
+    std::this_thread::sleep_for(chrono::microseconds(50));
+
+  }
+
+}
+
+//-------------------------------------------------------------------------
+//many stalls = the digitiser threads are the bottleneck, add more
+
+void DigiPipeline::Stop() {
+
+  if (threads.size() == 0) return;
+
+  stop.store(true,memory_order_release);
+
+  for (int t=0; t<threads.size(); t++) {
+    threads[t].join();
+  }
+  threads.clear();
+
+  long long n = published.load();
+
+  cout << "DigiPipeline: " << n << " events digitised in "
+       << batches.load() << " batches ("
+       << (batches.load()>0 ? double(n)/batches.load() : 0) << " per batch), "
+       << stalls.load() << " publishes waited for room" << endl;
+
+}
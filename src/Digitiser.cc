@@ -0,0 +1,314 @@
+#include "Digitiser.hh"
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+  bool Decend(double i,double j) {
+    return (i>j);//used to sort gamma enery array
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+Digitiser::Digitiser() {
+
+  name = "";
+  Conv = true;
+  k = 0.1733;
+  scale = 0.7;
+  threshold = 0;
+  trigger = 0;
+  addback = false;
+
+  SetDead("none");
+  SetCrystals("none");
+
+}
+
+//-------------------------------------------------------------------------
+
+Digitiser::Digitiser(InputManager* InMgr) {
+
+  name = "";
+  InMgr->GetVariable("Conv",Conv);
+  InMgr->GetVariable("res_k",k);
+  InMgr->GetVariable("res_scale",scale);
+  InMgr->GetVariable("crys_threshold",threshold);
+  InMgr->GetVariable("E0_threshold",trigger);
+  InMgr->GetVariable("Addback",addback);
+
+  string list, FileName;
+  InMgr->GetVariable("dead_crys",list);
+  InMgr->GetVariable("CrysFile",FileName);
+  SetDead(list);
+  SetCrystals(FileName);
+
+}
+
+//-------------------------------------------------------------------------
+
+Digitiser::Digitiser(string line) {
+
+  string list;
+  stringstream sstr(line);
+
+  if (!(sstr >> name >> Conv >> k >> scale >> threshold >> trigger >> list)) {
+    cerr << "error: digitiser config \"" << line << "\" needs name Conv res_k res_scale crys_threshold E0_threshold dead_crys" << endl;
+    exit(1);
+  }
+
+  string FileName = "none";
+  if (!(sstr >> addback)) addback = false;//optional columns
+  else sstr >> FileName;
+
+  SetDead(list);
+  SetCrystals(FileName);
+
+}
+
+//-------------------------------------------------------------------------
+//dead crystal copy numbers, comma separated, or none
+
+void Digitiser::SetDead(string list) {
+
+  for (int i=0; i<max_crys; i++) {
+    dead[i] = false;
+  }
+
+  if (list == "none") return;
+
+  for (int i=0; i<list.size(); i++) {
+    if (list[i] == ',') list[i] = ' ';
+  }
+
+  stringstream sstr(list);
+  int n;
+  while (sstr >> n) {
+    if (n<0 || n>=max_crys) {
+      cerr << "error: dead_crys " << n << " is not a crystal copy number" << endl;
+      exit(1);
+    }
+    dead[n] = true;
+  }
+
+}
+
+//-------------------------------------------------------------------------
+//one line per crystal to change: "det gain offset threshold res_k res_scale
+//enable", # = comment; the others keep the global values
+
+void Digitiser::SetCrystals(string FileName) {
+
+  double factor = sqrt(8.0*log(2.0));
+
+  for (int i=0; i<max_crys; i++) {
+    c_gain[i] = 1;
+    c_offset[i] = 0;
+    c_threshold[i] = threshold;
+    c_sigma[i] = k/factor*scale;
+    c_enable[i] = true;
+  }
+
+  if (FileName != "none") {
+
+    ifstream ifs(FileName.c_str());
+    if (!ifs.good()) {
+      cerr << "error: cannot read crystal tables " << FileName << endl;
+      exit(1);
+    }
+
+    string line;
+
+    while (getline(ifs,line)) {
+
+      line = line.substr(0, line.find("#"));
+      if (line.find_first_not_of(" \t") == string::npos) continue;
+
+      int n;
+      double gain, offset, thres, res_k, res_scale;
+      bool enable;
+      stringstream sstr(line);
+
+      if (!(sstr >> n >> gain >> offset >> thres >> res_k >> res_scale >> enable) || n<0 || n>=max_crys) {
+        cerr << "error: crystal table line \"" << line << "\" needs det gain offset threshold res_k res_scale enable" << endl;
+        exit(1);
+      }
+
+      c_gain[n] = gain;
+      c_offset[n] = offset;
+      c_threshold[n] = thres;
+      c_sigma[n] = res_k/factor*res_scale;
+      c_enable[n] = enable;
+
+    }
+
+  }
+
+  for (int i=0; i<max_crys; i++) {
+    if (dead[i]) c_enable[i] = false;
+    if (Conv == false) c_sigma[i] = 0;
+  }
+
+}
+
+//-------------------------------------------------------------------------
+//calibration of copy number n as Digitise applies it: E = gain*(dep +
+//sigma*sqrt(dep)*gaus)+offset, kept if at or above thres (0 = none)
+
+bool Digitiser::GetCrystal(int n, double& gain, double& offset, double& sigma, double& thres) {
+
+  if (n<0 || n>=max_crys || c_enable[n] == false) return false;
+
+  gain = c_gain[n];
+  offset = c_offset[n];
+  sigma = c_sigma[n];
+  thres = c_threshold[n];
+
+  return true;
+
+}
+
+//-------------------------------------------------------------------------
+//fan-out configs, # = comment, "none" = no file
+
+void Digitiser::ReadList(string FileName, std::vector<Digitiser>& list) {
+
+  list.clear();
+
+  if (FileName == "none") return;
+
+  ifstream ifs(FileName.c_str());
+  if (!ifs.good()) {
+    cerr << "error: cannot read digitiser configs " << FileName << endl;
+    exit(1);
+  }
+
+  string line;
+
+  while (getline(ifs,line)) {
+    line = line.substr(0, line.find("#")); // # = comment
+    if (line.find_first_not_of(" \t") == string::npos) continue;
+    list.push_back(Digitiser(line));
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+Digitiser::~Digitiser() {
+
+}
+
+//-------------------------------------------------------------------------
+//BGO resolution, FWHM = k*sqrt(E) scaled by 0.7 by default
+
+double Digitiser::Sigma(double E) {
+
+  double factor = sqrt(8.0*log(2.0));
+
+  return 1.*(k*sqrt(E))/factor*scale;
+
+}
+
+//-------------------------------------------------------------------------
+//raw[i] is the unsmeared deposit (MeV) of crystal det[i]. The deposits are
+//spread over arrays by copy number and calibrated, smeared and thresholded
+//in one pass over all crystals; only the Gaussian draws are per hit, in hit
+//order. Smeared energies at or below 0 are kept as 0, as the simulation
+//always did
+
+void Digitiser::Digitise(const std::vector<double>& raw, const std::vector<int>& det, std::vector<double>& E, std::vector<int>& E_det, TRandom* rng) {
+
+  double dep[max_crys] = {};
+  double noise[max_crys] = {};
+  double cal[max_crys];
+
+  E.clear();
+  E_det.clear();
+
+  for (int i=0; i<raw.size(); i++) {//SD copy numbers are always in range
+    if (det[i]<0 || det[i]>=max_crys || c_enable[det[i]] == false) continue;
+    dep[det[i]] += raw[i];
+    if (Conv) noise[det[i]] = rng->Gaus(0.,1.);
+  }
+
+  for (int n=0; n<max_crys; n++) {//no branches, vectorises
+    double e = dep[n]+noise[n]*c_sigma[n]*sqrt(dep[n]);
+    e = c_gain[n]*e+c_offset[n];
+    cal[n] = (e<0.) ? 0. : e;
+  }
+
+  for (int i=0; i<raw.size(); i++) {
+
+    int n = det[i];
+    if (n<0 || n>=max_crys || c_enable[n] == false) continue;
+    if (cal[n]<0 || (c_threshold[n]>0 && cal[n]<c_threshold[n])) continue;
+
+    E.push_back(cal[n]);
+    E_det.push_back(n);
+    cal[n] = -1;//reported once, even if listed twice
+
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+void Digitiser::Clear(Data_Event& event) {
+
+  event.sum = -1;
+  event.Mult = -1;
+  event.Cluster = -1;
+
+  for (int i=0; i<10; i++) {
+    event.esort[i] = -1;
+  }
+
+  for (int i=0; i<30; i++) {
+    event.ecal[i] = -1;
+  }
+
+}
+
+//-------------------------------------------------------------------------
+//E[i] is the energy (MeV) seen by detector det[i]; E_sort returns the
+//energies in decending order. Returns true for a coincidence (E0 above the
+//E0 threshold, 0 by default)
+
+bool Digitiser::Build(const std::vector<double>& E, const std::vector<int>& det, Data_Event& event, std::vector<double>& E_sort) {
+
+  Clear(event);
+
+  if (E.size() == 0) {
+    E_sort.clear();
+    return false;
+  }
+
+  if (addback) Addback::Cluster(E,det,E_sort);//one energy per cluster
+  else E_sort = E;
+
+  std::sort(E_sort.begin(),E_sort.end(),Decend);//sort energy array in decending order
+
+  if (E_sort[0]<=0.0 || E_sort[0]<=trigger) return false;
+
+  double Etot = 0;
+
+  for (int i=0; i<E_sort.size(); i++) {
+    if (i<10) event.esort[i] = E_sort[i];
+    Etot += E_sort[i];
+  }
+
+  for (int i=0; i<E.size(); i++) {
+    int detnum = det[i]-1;//numbering scheme as of August 2014
+    if (detnum>=0 && detnum<30) event.ecal[detnum] = E[i];
+  }
+
+  event.Mult = E.size();//multiplicity
+  event.Cluster = E_sort.size();
+  event.sum = Etot;
+
+  return true;
+
+}
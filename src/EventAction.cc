@@ -1,10 +1,11 @@
 #include "EventAction.hh"
 
-EventAction::EventAction(DAQManager* aDAQMgr) {
+EventAction::EventAction(DAQManager* aDAQMgr, bool aowner) {
 
 //  eventMessenger = new EventActionMessenger(this);
 
   DAQMgr = aDAQMgr;
+  owner = aowner;
 
 }
 
@@ -12,16 +13,17 @@ EventAction::EventAction(DAQManager* aDAQMgr) {
 EventAction::~EventAction() {
 
 //  delete eventMessenger;
+  if (owner) delete DAQMgr;
 
 }
 
 
 void EventAction::BeginOfEventAction(const G4Event* evt) {
   
-  DAQMgr->StartOfEvent();
-
   G4int evtNb = evt->GetEventID();
 
+  DAQMgr->StartOfEvent(evtNb);
+
 //  G4cout << "\n---> Begin of event: " << evtNb << G4endl;//verbosity = high
 
 }
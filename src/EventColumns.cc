@@ -0,0 +1,319 @@
+#include "EventColumns.hh"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <iostream>
+#include <zlib.h>
+
+namespace {
+
+  const char magic[8] = "BGOCOL1";
+
+  void Shuffle(const unsigned char* in, unsigned char* out, int n) {//n values of 4 bytes
+    for (int i=0; i<n; i++) {
+      out[i]     = in[4*i];
+      out[n+i]   = in[4*i+1];
+      out[2*n+i] = in[4*i+2];
+      out[3*n+i] = in[4*i+3];
+    }
+  }
+
+  void Unshuffle(const unsigned char* in, unsigned char* out, int n) {
+    for (int i=0; i<n; i++) {
+      out[4*i]   = in[i];
+      out[4*i+1] = in[n+i];
+      out[4*i+2] = in[2*n+i];
+      out[4*i+3] = in[3*n+i];
+    }
+  }
+
+  bool IsInt(int column) {
+    return column == Columns::Mult || column == Columns::Cluster || column == Columns::Run;
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+ColumnWriter::ColumnWriter() {
+
+  f = 0;
+  level = 0;
+  n_event = 0;
+  n = 0;
+
+}
+
+ColumnWriter::~ColumnWriter() {
+
+  if (f) Finish();
+
+}
+
+//-------------------------------------------------------------------------
+
+bool ColumnWriter::Create(string FileName, int alevel) {
+
+  f = fopen(FileName.c_str(),"wb");
+  if (f == 0) {
+    cerr << "error: cannot write " << FileName << endl;
+    return false;
+  }
+
+  level = alevel;
+  n_event = 0;
+  n = 0;
+  directory.clear();
+  buffer.assign(Columns::n_column*Columns::block_events,0.f);
+  packed.resize(compressBound(Columns::block_events*4)+Columns::block_events*4);
+
+  ColHeader h;//placeholder, rewritten by Finish
+  memset(&h,0,sizeof(h));
+  fwrite(&h,sizeof(h),1,f);
+
+  return true;
+
+}
+
+//-------------------------------------------------------------------------
+
+void ColumnWriter::Fill(const Data_Event& event, Int_t run) {
+
+  float* b = &buffer[n];
+  const int stride = Columns::block_events;
+
+  b[Columns::Sum*stride] = event.sum;
+  for (int k=0; k<10; k++) {
+    b[(Columns::Esort+k)*stride] = event.esort[k];
+  }
+  for (int k=0; k<30; k++) {
+    b[(Columns::Ecal+k)*stride] = event.ecal[k];
+  }
+  memcpy(&b[Columns::Mult*stride],&event.Mult,4);//int columns keep their bits
+  memcpy(&b[Columns::Cluster*stride],&event.Cluster,4);
+  memcpy(&b[Columns::Run*stride],&run,4);
+
+  n += 1;
+  n_event += 1;
+
+  if (n == Columns::block_events) WriteBlock();
+
+}
+
+//-------------------------------------------------------------------------
+
+void ColumnWriter::WriteBlock() {
+
+  if (n == 0) return;
+
+  for (int c=0; c<Columns::n_column; c++) {
+
+    const float* v = &buffer[c*Columns::block_events];
+    BlockInfo info;
+
+    info.min = 1.e300;
+    info.max = -1.e300;
+    for (int i=0; i<n; i++) {
+      double x;
+      if (IsInt(c)) x = ((const Int_t*)v)[i];
+      else x = v[i];
+      if (x<info.min) info.min = x;
+      if (x>info.max) info.max = x;
+    }
+
+    uLongf bytes = packed.size()-n*4;
+    unsigned char* plane = &packed[packed.size()-n*4];//shuffled copy at the end
+
+    info.packed = 0;
+    if (level>0) {
+      Shuffle((const unsigned char*)v,plane,n);
+      if (compress2(&packed[0],&bytes,plane,n*4,level) == Z_OK && bytes<n*4) info.packed = 1;
+    }
+
+    long pos = ftell(f);
+
+    if (info.packed == 0) {//raw: aligned, read in place
+      static const char zero[64] = {};
+      long pad = (64-pos%64)%64;
+      fwrite(zero,1,pad,f);
+      pos += pad;
+      bytes = n*4;
+      fwrite(v,1,bytes,f);
+    }
+    else fwrite(&packed[0],1,bytes,f);
+
+    info.offset = pos;
+    info.bytes = bytes;
+    directory.push_back(info);
+
+  }
+
+  n = 0;
+
+}
+
+//-------------------------------------------------------------------------
+
+bool ColumnWriter::Finish() {
+
+  if (f == 0) return false;
+
+  WriteBlock();
+
+  ColHeader h;
+  memset(&h,0,sizeof(h));
+  memcpy(h.magic,magic,8);
+  h.n_column = Columns::n_column;
+  h.block_events = Columns::block_events;
+  h.n_event = n_event;
+  h.n_block = directory.size()/Columns::n_column;
+  h.level = level;
+  h.directory = ftell(f);
+
+  bool ok = directory.size() == 0 || fwrite(&directory[0],sizeof(BlockInfo),directory.size(),f) == directory.size();
+  ok = ok && fseek(f,0,SEEK_SET) == 0 && fwrite(&h,sizeof(h),1,f) == 1;
+  ok = (fclose(f) == 0) && ok;
+  f = 0;
+
+  if (ok == false) cerr << "error: cannot write the column file" << endl;
+
+  std::vector<float>().swap(buffer);
+  directory.clear();
+
+  return ok;
+
+}
+
+//-------------------------------------------------------------------------
+
+ColumnReader::ColumnReader() {
+
+  map = 0;
+  size = 0;
+  header = 0;
+  directory = 0;
+
+}
+
+ColumnReader::~ColumnReader() {
+
+  Close();
+
+}
+
+//-------------------------------------------------------------------------
+
+bool ColumnReader::Open(string FileName) {
+
+  Close();
+
+  int fd = open(FileName.c_str(),O_RDONLY);
+  if (fd<0) {
+    cerr << "error: cannot read " << FileName << endl;
+    return false;
+  }
+
+  struct stat st;
+  fstat(fd,&st);
+  size = st.st_size;
+
+  if (size<sizeof(ColHeader)) {
+    cerr << "error: " << FileName << " is not a column file" << endl;
+    close(fd);
+    return false;
+  }
+
+  map = mmap(0,size,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);//the mapping stays valid
+
+  if (map == MAP_FAILED) {
+    cerr << "error: cannot map " << FileName << endl;
+    map = 0;
+    return false;
+  }
+
+  header = (const ColHeader*)map;
+
+  if (memcmp(header->magic,magic,8) != 0 || header->n_column != Columns::n_column
+      || header->block_events != Columns::block_events || header->n_block<0
+      || header->directory<sizeof(ColHeader)
+      || size<header->directory+header->n_block*header->n_column*sizeof(BlockInfo)) {
+    cerr << "error: " << FileName << " is not a column file or was not finished" << endl;
+    Close();
+    return false;
+  }
+
+  directory = (const BlockInfo*)((const char*)map+header->directory);
+
+  cache.assign(header->n_column,std::vector<float>());
+  cached.assign(header->n_column,-1);
+
+  return true;
+
+}
+
+//-------------------------------------------------------------------------
+
+void ColumnReader::Close() {
+
+  if (map) munmap(map,size);
+
+  map = 0;
+  size = 0;
+  header = 0;
+  directory = 0;
+  cache.clear();
+  cached.clear();
+
+}
+
+//-------------------------------------------------------------------------
+
+int ColumnReader::BlockEvents(int b) const {
+
+  int64_t left = header->n_event-int64_t(b)*header->block_events;
+
+  return (left<header->block_events) ? left : header->block_events;
+
+}
+
+//-------------------------------------------------------------------------
+
+const float* ColumnReader::Float(int column, int b) {
+
+  const BlockInfo& info = Info(column,b);
+  const unsigned char* p = (const unsigned char*)map+info.offset;
+
+  if (info.packed == 0) return (const float*)p;//no copy
+
+  if (cached[column] == b) return &cache[column][0];
+
+  int n = BlockEvents(b);
+  uLongf bytes = n*4;
+
+  scratch.resize(bytes);
+  cache[column].resize(n);
+
+  if (uncompress(&scratch[0],&bytes,p,info.bytes) != Z_OK || bytes != n*4) {
+    cerr << "error: block " << b << " of column " << column << " is corrupt" << endl;
+    cache[column].assign(n,0.f);
+  }
+  else Unshuffle(&scratch[0],(unsigned char*)&cache[column][0],n);
+
+  cached[column] = b;
+
+  return &cache[column][0];
+
+}
+
+//-------------------------------------------------------------------------
+
+bool ColumnReader::Overlaps(int column, int b, double low, double high) const {
+
+  const BlockInfo& info = Info(column,b);
+
+  return info.max>=low && info.min<=high;
+
+}
@@ -0,0 +1,145 @@
+#include "EventPool.hh"
+#include "TFile.h"
+#include "TTree.h"
+#include <iostream>
+#include <map>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+  struct Data_Run {
+    Int_t Event;
+    Int_t Run;
+    Float_t cascade[10];
+  };
+
+}
+
+//-------------------------------------------------------------------------
+
+EventPool::EventPool() {
+
+}
+
+//-------------------------------------------------------------------------
+
+EventPool::~EventPool() {
+
+}
+
+//-------------------------------------------------------------------------
+//the Run tree maps each run to its energy, Raw entries are bucketed by run
+
+void EventPool::Read(const char* FileName) {
+
+  TFile* f = new TFile(FileName);
+  if (f->IsZombie()) {
+    cerr << "error: cannot read library " << FileName << endl;
+    exit(1);
+  }
+
+  TTree* t_run = (TTree*)f->Get("Run");
+  TTree* t_pool = (TTree*)f->Get("Raw");
+  if (t_run==0 || t_pool==0) {
+    cerr << "error: " << FileName << " has no Run/Raw tree, not a \"Library\" run?" << endl;
+    exit(1);
+  }
+
+  Data_Run data_run = {};
+  Raw_Event pool;
+
+  t_run->SetBranchAddress("Run",&data_run);
+  t_pool->SetBranchAddress("Run",&pool.Run);
+  t_pool->SetBranchAddress("n",&pool.n);
+  t_pool->SetBranchAddress("det",pool.det);
+  t_pool->SetBranchAddress("dep",pool.dep);
+
+  std::map<int,Energy> bucket;//run -> events
+
+  for (int i=0; i<t_run->GetEntries(); i++) {
+    t_run->GetEntry(i);
+    if (data_run.cascade[1]>0) {
+      cerr << "error: " << FileName << " run " << data_run.Run << " is not a single gamma" << endl;
+      exit(1);
+    }
+    bucket[data_run.Run].E = data_run.cascade[0];
+    bucket[data_run.Run].offset.push_back(0);
+  }
+
+  for (int i=0; i<t_pool->GetEntries(); i++) {
+
+    t_pool->GetEntry(i);
+
+    std::map<int,Energy>::iterator it = bucket.find(pool.Run);
+    if (it == bucket.end()) continue;
+
+    Energy& e = it->second;
+
+    for (int j=0; j<pool.n && j<max_crys; j++) {
+      e.det.push_back(pool.det[j]);
+      e.dep.push_back(pool.dep[j]);
+    }
+
+    e.offset.push_back(e.det.size());
+
+  }
+
+  delete f;
+
+  std::map<int,Energy>::iterator it;
+
+  for (it=bucket.begin(); it!=bucket.end(); it++) {
+
+    if (it->second.offset.size()<2) continue;//no events
+
+    int i = std::lower_bound(E_grid.begin(),E_grid.end(),it->second.E)-E_grid.begin();
+
+    if (i<E_grid.size() && E_grid[i]==it->second.E) {//same energy in an earlier file: append
+      Energy& e = grid[i];
+      int shift = e.det.size();
+      e.det.insert(e.det.end(),it->second.det.begin(),it->second.det.end());
+      e.dep.insert(e.dep.end(),it->second.dep.begin(),it->second.dep.end());
+      for (int j=1; j<it->second.offset.size(); j++) {
+        e.offset.push_back(it->second.offset[j]+shift);
+      }
+      continue;
+    }
+
+    E_grid.insert(E_grid.begin()+i,it->second.E);
+    grid.insert(grid.begin()+i,it->second);
+
+  }
+
+  cout << FileName << ": " << bucket.size() << " library energies, " << grid.size() << " in pool" << endl;
+
+}
+
+//-------------------------------------------------------------------------
+//gammas between grid energies use one of the two neighbouring energies,
+//chosen with linear weights, with the deposits scaled to E
+
+void EventPool::AddGamma(double E, double deposit[max_crys], TRandom* rng) {
+
+  int i = std::lower_bound(E_grid.begin(),E_grid.end(),E)-E_grid.begin();
+
+  if (i==E_grid.size() || (E_grid[i]>E && i==0)) {
+    cerr << "error: " << E << " MeV is outside the library grid " << GetEmin() << "-" << GetEmax() << " MeV" << endl;
+    exit(1);
+  }
+
+  if (E_grid[i]>E && rng->Rndm()>(E-E_grid[i-1])/(E_grid[i]-E_grid[i-1])) i -= 1;
+
+  const Energy& e = grid[i];
+
+  int n_event = e.offset.size()-1;
+  int k = rng->Integer(n_event);
+  double scale = E/e.E;
+
+  for (int j=e.offset[k]; j<e.offset[k+1]; j++) {
+    deposit[e.det[j]] += e.dep[j]*scale;
+  }
+
+}
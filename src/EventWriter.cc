@@ -0,0 +1,196 @@
+#include "EventWriter.hh"
+#include "TFile.h"
+#include <chrono>
+#include <iostream>
+
+using namespace std;
+
+//-------------------------------------------------------------------------
+
+EventWriter::EventWriter(int size) {
+
+  size_t n = 2;
+  while (n<size) n *= 2;
+
+  cells = new Cell[n];
+  mask = n-1;
+
+  for (size_t i=0; i<n; i++) {
+    cells[i].seq.store(i,memory_order_relaxed);
+  }
+
+  head.store(0);
+  tail.store(0);
+  stop.store(false);
+  stalls.store(0);
+
+  EventTree = 0;
+  RawTree = 0;
+  columns = 0;
+  segments = 0;
+
+}
+
+//-------------------------------------------------------------------------
+
+EventWriter::~EventWriter() {
+
+  Stop();
+  delete[] cells;
+
+}
+
+//-------------------------------------------------------------------------
+//points the trees at the writer's own buffers and starts the thread, the
+//trees must not be filled by anyone else until Stop()
+
+void EventWriter::Start(TTree* aEventTree, TTree* aRawTree, ColumnWriter* acolumns, RunSegments* asegments) {
+
+  Stop();
+
+  EventTree = aEventTree;
+  RawTree = aRawTree;
+  columns = acolumns;
+  segments = asegments;
+
+  EventTree->SetBranchAddress("Events",&out.data);
+  if (EventTree->GetBranch("Run")) EventTree->SetBranchAddress("Run",&out.run);
+  if (EventTree->GetBranch("Cluster")) EventTree->SetBranchAddress("Cluster",&out.data.Cluster);
+
+  if (RawTree) {
+    RawTree->SetBranchAddress("Run",&out.raw.Run);
+    RawTree->SetBranchAddress("n",&out.raw.n);
+    RawTree->SetBranchAddress("det",out.raw.det);
+    RawTree->SetBranchAddress("dep",out.raw.dep);
+  }
+
+  N_written = 0;
+  busy = 0;
+  stalls.store(0);
+  stop.store(false);
+
+  writer = std::thread(&EventWriter::Loop,this);
+
+}
+
+//-------------------------------------------------------------------------
+//bounded queue after D. Vyukov: cell seq == pos means free for the push at
+//pos, seq == pos+1 means filled for the pop at pos
+
+bool EventWriter::TryPush(const Data_Event& data, Int_t run, const Raw_Event* raw) {
+
+  size_t pos = head.load(memory_order_relaxed);
+
+  while (true) {
+
+    Cell& c = cells[pos & mask];
+    size_t seq = c.seq.load(memory_order_acquire);
+    long long dif = (long long)seq - (long long)pos;
+
+    if (dif == 0) {
+      if (head.compare_exchange_weak(pos,pos+1,memory_order_relaxed)) {
+        c.rec.data = data;
+        c.rec.run = run;
+        if (raw) c.rec.raw = *raw;
+        c.seq.store(pos+1,memory_order_release);
+        return true;
+      }
+    }
+    else if (dif < 0) {
+      return false;//full
+    }
+    else {
+      pos = head.load(memory_order_relaxed);
+    }
+
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+bool EventWriter::TryPop(Record& rec) {
+
+  size_t pos = tail.load(memory_order_relaxed);
+  Cell& c = cells[pos & mask];
+  size_t seq = c.seq.load(memory_order_acquire);
+
+  if ((long long)seq - (long long)(pos+1) < 0) return false;//empty
+
+  rec = c.rec;
+  tail.store(pos+1,memory_order_relaxed);//single consumer
+  c.seq.store(pos+mask+1,memory_order_release);
+
+  return true;
+
+}
+
+//-------------------------------------------------------------------------
+//back-pressure: waits while the writer is behind
+
+void EventWriter::Push(const Data_Event& data, Int_t run, const Raw_Event* raw) {
+
+  if (TryPush(data,run,raw)) return;
+
+  stalls.fetch_add(1,memory_order_relaxed);
+
+  while (TryPush(data,run,raw) == false) {
+    std::this_thread::yield();
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+void EventWriter::Loop() {
+
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+  while (true) {
+
+    if (TryPop(out) == false) {
+      if (stop.load(memory_order_acquire)) {
+        if (TryPop(out) == false) break;//drained
+      }
+      else {
+        std::this_thread::sleep_for(chrono::microseconds(50));
+        continue;
+      }
+    }
+
+    chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+
+    EventTree->Fill();
+    if (RawTree) RawTree->Fill();
+    if (columns) columns->Fill(out.data,out.run);
+    if (segments) segments->Add(out.run);
+
+    busy += chrono::duration<double>(chrono::steady_clock::now()-t0).count();
+    N_written += 1;
+
+  }
+
+  wall = chrono::duration<double>(chrono::steady_clock::now()-start).count();
+
+}
+
+//-------------------------------------------------------------------------
+//busy near 100% or many stalls = I/O bound, otherwise transport bound
+
+void EventWriter::Stop() {
+
+  if (writer.joinable() == false) return;
+
+  stop.store(true,memory_order_release);
+  writer.join();
+
+  double MB = 0;
+  if (EventTree->GetCurrentFile()) MB = EventTree->GetCurrentFile()->GetBytesWritten()/1.e6;
+
+  cout << "EventWriter: " << N_written << " events in " << wall << " s, "
+       << (wall>0 ? N_written/wall : 0) << " events/s, "
+       << (wall>0 ? 100.*busy/wall : 0) << "% busy, "
+       << stalls.load() << " pushes waited for room, "
+       << MB << " MB written to file" << endl;
+
+}
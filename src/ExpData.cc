@@ -0,0 +1,186 @@
+#include "ExpData.hh"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+
+namespace {
+  const char magic[8] = "BGOEXP1";
+}
+
+//-------------------------------------------------------------------------
+
+ExpData::ExpData() {
+
+  map = 0;
+  size = 0;
+  header = 0;
+
+}
+
+//-------------------------------------------------------------------------
+
+ExpData::~ExpData() {
+
+  Close();
+
+}
+
+//-------------------------------------------------------------------------
+
+bool ExpData::Open(string FileName) {
+
+  Close();
+
+  int fd = open(FileName.c_str(),O_RDONLY);
+  if (fd<0) {
+    cerr << "error: cannot read " << FileName << endl;
+    return false;
+  }
+
+  struct stat st;
+  fstat(fd,&st);
+  size = st.st_size;
+
+  if (size<sizeof(ExpHeader)) {
+    cerr << "error: " << FileName << " is not an experimental dataset" << endl;
+    close(fd);
+    return false;
+  }
+
+  map = mmap(0,size,PROT_READ,MAP_PRIVATE,fd,0);
+  close(fd);//the mapping stays valid
+
+  if (map == MAP_FAILED) {
+    cerr << "error: cannot map " << FileName << endl;
+    map = 0;
+    return false;
+  }
+
+  header = (const ExpHeader*)map;
+
+  size_t payload = (header->kind == Binned) ? NBins()*sizeof(double) : header->n*header->n_var*sizeof(float);
+
+  if (memcmp(header->magic,magic,8) != 0 || header->n_x<1 || header->n_y<0
+      || (header->kind == Binned && header->n != NBins())
+      || (header->kind == Events && (header->n_var<1 || header->n_var>2))
+      || size<sizeof(ExpHeader)+payload) {
+    cerr << "error: " << FileName << " is not an experimental dataset or is truncated" << endl;
+    Close();
+    return false;
+  }
+
+  return true;
+
+}
+
+//-------------------------------------------------------------------------
+
+void ExpData::Close() {
+
+  if (map) munmap(map,size);
+
+  map = 0;
+  size = 0;
+  header = 0;
+
+}
+
+//-------------------------------------------------------------------------
+
+const double* ExpData::BinData() const {
+  return (const double*)((const char*)map+sizeof(ExpHeader));
+}
+
+const float* ExpData::EventData() const {
+  return (const float*)((const char*)map+sizeof(ExpHeader));
+}
+
+int ExpData::NBins() const {
+  return header->n_x*(header->n_y>0 ? header->n_y : 1);
+}
+
+//-------------------------------------------------------------------------
+//as TH1/TH2 bins 1...n, low edge inclusive; under- and overflow are not
+//part of the comparison
+
+int ExpData::Bin(double x, double y) const {
+
+  if (!(x>=header->x_min && x<header->x_max)) return -1;
+  int bx = int((x-header->x_min)/(header->x_max-header->x_min)*header->n_x);
+  if (bx>=header->n_x) bx = header->n_x-1;
+
+  if (header->n_y == 0) return bx;
+
+  if (!(y>=header->y_min && y<header->y_max)) return -1;
+  int by = int((y-header->y_min)/(header->y_max-header->y_min)*header->n_y);
+  if (by>=header->n_y) by = header->n_y-1;
+
+  return by*header->n_x+bx;
+
+}
+
+//-------------------------------------------------------------------------
+
+void ExpData::GetBins(std::vector<double>& bins) const {
+
+  if (header->kind == Binned) {
+    bins.assign(BinData(),BinData()+NBins());
+    return;
+  }
+
+  bins.assign(NBins(),0.);
+
+  const float* ev = EventData();
+
+  for (int64_t i=0; i<header->n; i++) {
+    double x = ev[i*header->n_var];
+    double y = (header->n_var>1) ? ev[i*header->n_var+1] : 0.;
+    int b = Bin(x,y);
+    if (b>=0) bins[b] += 1;
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+bool ExpData::Write(string FileName, const ExpHeader& h, const void* payload) {
+
+  ExpHeader out = h;
+  memcpy(out.magic,magic,8);
+
+  size_t n_bin = h.n_x*(h.n_y>0 ? h.n_y : 1);
+  size_t bytes = (h.kind == Binned) ? n_bin*sizeof(double) : h.n*h.n_var*sizeof(float);
+
+  FILE* f = fopen(FileName.c_str(),"wb");
+  if (f == 0) {
+    cerr << "error: cannot write " << FileName << endl;
+    return false;
+  }
+
+  bool ok = fwrite(&out,sizeof(out),1,f) == 1;
+  if (bytes>0) ok = ok && fwrite(payload,bytes,1,f) == 1;
+  ok = (fclose(f) == 0) && ok;
+
+  if (ok == false) cerr << "error: cannot write " << FileName << endl;
+
+  return ok;
+
+}
+
+//-------------------------------------------------------------------------
+
+bool ExpData::ParseQuantity(string name, int& q) {
+
+  if (name == "Mult") q = Mult;
+  else if (name == "E0") q = E0;
+  else if (name == "E0E1") q = E0E1;
+  else if (name == "GG") q = GammaGamma;
+  else return false;
+
+  return true;
+
+}
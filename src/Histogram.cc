@@ -0,0 +1,124 @@
+#include "Histogram.hh"
+#include <new>
+
+namespace {
+  const size_t cache_line = 64;
+}
+
+//-------------------------------------------------------------------------
+
+Histogram::Histogram(int anx, double axmin, double axmax) {
+
+  nx = anx; xmin = axmin; xmax = axmax;
+  ny = 0; ymin = 0; ymax = 1;
+
+  Allocate();
+
+}
+
+//-------------------------------------------------------------------------
+
+Histogram::Histogram(int anx, double axmin, double axmax, int any, double aymin, double aymax) {
+
+  nx = anx; xmin = axmin; xmax = axmax;
+  ny = any; ymin = aymin; ymax = aymax;
+
+  Allocate();
+
+}
+
+//-------------------------------------------------------------------------
+
+Histogram::~Histogram() {
+
+  delete[] memory;
+
+}
+
+//-------------------------------------------------------------------------
+//one block, bins start on a cache line
+
+void Histogram::Allocate() {
+
+  xscale = nx/(xmax-xmin);
+  yscale = (ny>0) ? ny/(ymax-ymin) : 0;
+  stride = nx+2;
+  n_cell = stride*(ny+2);
+
+  memory = new char[n_cell*sizeof(std::atomic<unsigned int>)+cache_line];
+
+  size_t address = reinterpret_cast<size_t>(memory);
+  address = (address+cache_line-1)/cache_line*cache_line;
+  bins = reinterpret_cast<std::atomic<unsigned int>*>(address);
+
+  for (int i=0; i<n_cell; i++) {
+    new (&bins[i]) std::atomic<unsigned int>(0);
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+void Histogram::Reset() {
+
+  for (int i=0; i<n_cell; i++) {
+    bins[i].store(0,std::memory_order_relaxed);
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+unsigned int Histogram::GetBinContent(int binx, int biny) const {
+
+  return bins[binx+stride*biny].load(std::memory_order_relaxed);
+
+}
+
+//-------------------------------------------------------------------------
+
+double Histogram::GetEntries() const {
+
+  double sum = 0;
+
+  for (int i=0; i<n_cell; i++) {
+    sum += bins[i].load(std::memory_order_relaxed);
+  }
+
+  return sum;
+
+}
+
+//-------------------------------------------------------------------------
+
+TH1F* Histogram::ToTH1F(const char* name) const {
+
+  TH1F* h = new TH1F(name,name,nx,xmin,xmax);
+
+  for (int i=0; i<stride; i++) {
+    h->SetBinContent(i,GetBinContent(i));
+  }
+
+  h->SetEntries(GetEntries());
+
+  return h;
+
+}
+
+//-------------------------------------------------------------------------
+
+TH2F* Histogram::ToTH2F(const char* name) const {
+
+  TH2F* h = new TH2F(name,name,nx,xmin,xmax,ny,ymin,ymax);
+
+  for (int j=0; j<ny+2; j++) {
+    for (int i=0; i<stride; i++) {
+      h->SetBinContent(i,j,GetBinContent(i,j));
+    }
+  }
+
+  h->SetEntries(GetEntries());
+
+  return h;
+
+}
@@ -0,0 +1,109 @@
+#include "Likelihood.hh"
+#include <cmath>
+
+//-------------------------------------------------------------------------
+
+Likelihood::Likelihood(const std::vector<double>& data) {
+
+  n_bin = data.size();
+  X = data;
+
+  total = 0;
+  lg_total = 0;
+  neyman_data = 0;
+
+  for (int i=0; i<n_bin; i++) {
+    total += X[i];
+    lg_total += lgamma(X[i]+1.);
+    neyman_data += X[i]*X[i]/(X[i]>1. ? X[i] : 1.);
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+Likelihood::~Likelihood() {
+
+}
+
+//-------------------------------------------------------------------------
+
+bool Likelihood::Parse(const std::string& name, Statistic& s) {
+
+  if (name == "poisson") s = Poisson;
+  else if (name == "pearson") s = Pearson;
+  else if (name == "neyman") s = Neyman;
+  else if (name == "cash") s = Cash;
+  else return false;
+
+  return true;
+
+}
+
+//-------------------------------------------------------------------------
+
+//N = norm M: sum X ln N = sum X ln M + total ln norm once no data bin has
+//M = 0, sum N = norm sum M
+
+double Likelihood::Evaluate(const double* model, Statistic s, bool normalise) const {
+
+  const double* x = &X[0];
+
+  int empty = 0;//M=0 under data
+  double sum = 0;
+
+  for (int i=0; i<n_bin; i++) {
+    sum += model[i];
+    empty += (model[i]<=0 && x[i]>0);
+  }
+
+  double norm = 1.;
+
+  if (normalise) {
+    if (sum<=0) return HUGE_VAL;//empty template
+    norm = total/sum;
+  }
+
+  if (s == Neyman) {//sum (X-N)^2/max(X,1)
+    double xm = 0, mm = 0;
+    for (int i=0; i<n_bin; i++) {
+      double w = 1./(x[i]>1. ? x[i] : 1.);
+      xm += x[i]*model[i]*w;
+      mm += model[i]*model[i]*w;
+    }
+    return neyman_data - 2*norm*xm + norm*norm*mm;
+  }
+
+  if (empty>0) return HUGE_VAL;
+
+  if (s == Pearson) {//sum X^2/N - 2 total + sum N, over N>0
+    double xx = 0;
+    for (int i=0; i<n_bin; i++) {
+      xx += (model[i]>0) ? x[i]*x[i]/model[i] : 0.;
+    }
+    return (norm>0 ? xx/norm : 0.) - 2*total + norm*sum;
+  }
+
+  double xlm = 0;//sum X ln M
+  for (int i=0; i<n_bin; i++) {
+    xlm += x[i]*log(model[i]>0 ? model[i] : 1.);
+  }
+
+  double C = 2*(norm*sum - xlm - (total>0 ? total*log(norm) : 0.));//2 sum[N - X ln N]
+
+  if (s == Poisson) return C + 2*lg_total;
+
+  return C;
+
+}
+
+//-------------------------------------------------------------------------
+//many templates (e.g. every cascade of a sweep) against the same data
+
+void Likelihood::Batch(const double* models, int n_model, Statistic s, double* result, bool normalise) const {
+
+  for (int m=0; m<n_model; m++) {
+    result[m] = Evaluate(models+(long long)m*n_bin,s,normalise);
+  }
+
+}
@@ -0,0 +1,340 @@
+#include "MixtureFit.hh"
+#include <cmath>
+#include <algorithm>
+
+namespace {
+  const int tile = 512;//bins per tile, 4 kB of doubles
+}
+
+//-------------------------------------------------------------------------
+
+MixtureFit::MixtureFit(int an_bin, int an_thread) {
+
+  n_bin = an_bin;
+  n_tmpl = 0;
+  n_thread = (an_thread<1) ? 1 : an_thread;
+
+  partial.assign(n_thread,std::vector<double>(n_bin));
+
+  current = 0;
+  generation = 0;
+  busy = 0;
+  quit = false;
+
+  for (int t=1; t<n_thread; t++) {//thread 0 is the caller
+    pool.push_back(std::thread(&MixtureFit::Worker,this,t));
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+MixtureFit::~MixtureFit() {
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    quit = true;
+  }
+  wake.notify_all();
+
+  for (int t=0; t<pool.size(); t++) {
+    pool[t].join();
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+void MixtureFit::Worker(int thread) {
+
+  long long seen = 0;
+
+  while (true) {
+
+    const std::function<void(int,int)>* job;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      wake.wait(lock,[&]{return quit || generation != seen;});
+      if (quit) return;
+      seen = generation;
+      job = current;
+    }
+
+    (*job)(thread,n_thread);
+
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      busy -= 1;
+    }
+    finished.notify_one();
+
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+void MixtureFit::Parallel(const std::function<void(int,int)>& job) {
+
+  if (n_thread == 1) {
+    job(0,1);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    current = &job;
+    busy = n_thread-1;
+    generation += 1;
+  }
+  wake.notify_all();
+
+  job(0,n_thread);
+
+  std::unique_lock<std::mutex> lock(mutex);
+  finished.wait(lock,[&]{return busy == 0;});
+
+}
+
+//-------------------------------------------------------------------------
+
+void MixtureFit::AddTemplate(const std::vector<double>& t) {
+
+  A.insert(A.end(),t.begin(),t.begin()+n_bin);
+
+  double sum = 0;
+  for (int b=0; b<n_bin; b++) {
+    sum += t[b];
+  }
+  colsum.push_back(sum);
+
+  n_tmpl += 1;
+
+}
+
+void MixtureFit::SetData(const std::vector<double>& ay) {
+  y.assign(ay.begin(),ay.begin()+n_bin);
+}
+
+//-------------------------------------------------------------------------
+//each thread sums its block of templates into its own bins, tile by tile,
+//then the bins are reduced by tiles across the threads
+
+void MixtureFit::Forward(const double* w, double* m) {
+
+  Parallel([&](int thread, int n) {
+
+    int t0 = (long long)n_tmpl*thread/n;
+    int t1 = (long long)n_tmpl*(thread+1)/n;
+    double* out = &partial[thread][0];
+
+    for (int b0=0; b0<n_bin; b0+=tile) {
+      int b1 = std::min(b0+tile,n_bin);
+      for (int b=b0; b<b1; b++) out[b] = 0;
+      for (int t=t0; t<t1; t++) {
+        double wt = w[t];
+        if (wt == 0) continue;
+        const double* a = &A[(size_t)t*n_bin];
+        for (int b=b0; b<b1; b++) {
+          out[b] += wt*a[b];
+        }
+      }
+    }
+
+  });
+
+  for (int b=0; b<n_bin; b++) {
+    double sum = 0;
+    for (int k=0; k<n_thread; k++) {
+      sum += partial[k][b];
+    }
+    m[b] = sum;
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+void MixtureFit::Back(const double* v, double* g) {
+
+  Parallel([&](int thread, int n) {
+
+    int t0 = (long long)n_tmpl*thread/n;
+    int t1 = (long long)n_tmpl*(thread+1)/n;
+
+    for (int t=t0; t<t1; t++) g[t] = 0;
+
+    for (int b0=0; b0<n_bin; b0+=tile) {//v tile stays in L1 for the block
+      int b1 = std::min(b0+tile,n_bin);
+      for (int t=t0; t<t1; t++) {
+        const double* a = &A[(size_t)t*n_bin];
+        double dot = 0;
+        for (int b=b0; b<b1; b++) {
+          dot += a[b]*v[b];
+        }
+        g[t] += dot;
+      }
+    }
+
+  });
+
+}
+
+//-------------------------------------------------------------------------
+
+void MixtureFit::Model(const std::vector<double>& w, std::vector<double>& m) {
+
+  m.resize(n_bin);
+  Forward(&w[0],&m[0]);
+
+}
+
+double MixtureFit::Deviance(const std::vector<double>& m) {
+
+  double D = 0;
+
+  for (int b=0; b<n_bin; b++) {
+    if (m[b]<=0) {
+      if (y[b]>0) return HUGE_VAL;
+      continue;
+    }
+    D += m[b]-y[b];
+    if (y[b]>0) D += y[b]*log(y[b]/m[b]);
+  }
+
+  return 2*D;
+
+}
+
+double MixtureFit::Neyman(const std::vector<double>& m) {
+
+  double chi2 = 0;
+
+  for (int b=0; b<n_bin; b++) {
+    chi2 += (y[b]-m[b])*(y[b]-m[b])/std::max(y[b],1.);
+  }
+
+  return chi2;
+
+}
+
+//-------------------------------------------------------------------------
+//ML-EM: w_t <- w_t (A^T (y/m))_t / sum_b A_bt, keeps w >= 0 and the fitted
+//total equal to the data. Starts flat unless w has n_tmpl values
+
+int MixtureFit::EM(std::vector<double>& w, int max_iter, double tol) {
+
+  double total = 0, tmpl = 0;
+  for (int b=0; b<n_bin; b++) total += y[b];
+  for (int t=0; t<n_tmpl; t++) tmpl += colsum[t];
+
+  if (w.size() != n_tmpl) w.assign(n_tmpl,(tmpl>0) ? total/tmpl : 0.);
+
+  std::vector<double> m(n_bin), v(n_bin), g(n_tmpl);
+  double last = HUGE_VAL;
+  int iter;
+
+  for (iter=1; iter<=max_iter; iter++) {
+
+    Forward(&w[0],&m[0]);
+
+    for (int b=0; b<n_bin; b++) {
+      v[b] = (m[b]>0) ? y[b]/m[b] : 0.;
+    }
+
+    Back(&v[0],&g[0]);
+
+    for (int t=0; t<n_tmpl; t++) {
+      w[t] = (colsum[t]>0) ? w[t]*g[t]/colsum[t] : 0.;
+    }
+
+    double D = Deviance(m);
+    if (fabs(last-D) <= tol*std::max(1.,fabs(D))) break;
+    last = D;
+
+  }
+
+  return std::min(iter,max_iter);
+
+}
+
+//-------------------------------------------------------------------------
+//FISTA on f(w) = 1/2 sum s_b (A w - y)_b^2, s_b = 1/max(y_b,1), projected
+//on w >= 0. The step is 1/L with L the largest eigenvalue of A^T S A, from
+//a power iteration
+
+int MixtureFit::NNLS(std::vector<double>& w, int max_iter, double tol) {
+
+  if (w.size() != n_tmpl) w.assign(n_tmpl,0.);
+
+  std::vector<double> s(n_bin), m(n_bin), r(n_bin), g(n_tmpl);
+  std::vector<double> z(n_tmpl,1.), w_prev;
+
+  for (int b=0; b<n_bin; b++) {
+    s[b] = 1./std::max(y[b],1.);
+  }
+
+  double L = 0;
+
+  for (int k=0; k<30; k++) {//power iteration on A^T S A
+
+    double norm = 0;
+    for (int t=0; t<n_tmpl; t++) norm += z[t]*z[t];
+    norm = sqrt(norm);
+    if (norm == 0) return 0;
+    for (int t=0; t<n_tmpl; t++) z[t] /= norm;
+
+    Forward(&z[0],&m[0]);
+    for (int b=0; b<n_bin; b++) r[b] = s[b]*m[b];
+    Back(&r[0],&z[0]);
+
+    double eig = 0;
+    for (int t=0; t<n_tmpl; t++) eig += z[t]*z[t];
+    L = sqrt(eig);//|A^T S A z| with |z| = 1
+
+  }
+
+  if (L <= 0) return 0;
+
+  w_prev = w;
+  z = w;
+  double theta = 1;
+  double last = HUGE_VAL;
+  int iter;
+
+  for (iter=1; iter<=max_iter; iter++) {
+
+    Forward(&z[0],&m[0]);
+    for (int b=0; b<n_bin; b++) r[b] = s[b]*(m[b]-y[b]);
+    Back(&r[0],&g[0]);
+
+    w_prev.swap(w);
+    for (int t=0; t<n_tmpl; t++) {
+      w[t] = std::max(0.,z[t]-g[t]/L);
+    }
+
+    double theta_next = (1+sqrt(1+4*theta*theta))/2;
+    double beta = (theta-1)/theta_next;
+    theta = theta_next;
+
+    for (int t=0; t<n_tmpl; t++) {
+      z[t] = w[t]+beta*(w[t]-w_prev[t]);
+    }
+
+    if (iter%10 == 0) {//objective at w, every 10 steps
+      Forward(&w[0],&m[0]);
+      double chi2 = Neyman(m);
+      if (fabs(last-chi2) <= tol*std::max(1.,chi2)) break;
+      if (chi2>last) {//restart the momentum
+        z = w;
+        theta = 1;
+      }
+      last = chi2;
+    }
+
+  }
+
+  return std::min(iter,max_iter);
+
+}
@@ -4,6 +4,7 @@
 #include "G4ParticleGun.hh"
 #include "G4ParticleTable.hh"
 #include "G4ParticleDefinition.hh"
+#include "Randomize.hh"
 #include "CascadeGenerator.hh"
 #include "TF1.h"
 #include "TRandom.h"
@@ -31,26 +32,18 @@ using std::time;
 
 #include "TRandom.h"
 
-G4ParticleTable* particleTable = G4ParticleTable::GetParticleTable();
-int decaynum;
-double phi_old;
-
-TF1 *f1;
-TF1 *f2;
-TF1 *f3;
-
 //---------------------------------------------------------------------------------
 PrimaryGeneratorAction::PrimaryGeneratorAction(CascadeGenerator *aCasGen) {
 
   CasGen = aCasGen;
 
   srand(time(0)); //seeds random number generator
-  gRandom->SetSeed();
   G4int n_particle = 1;
   particleGun = new G4ParticleGun(n_particle);
 
-  f1 = new TF1("f1","1",-1,1);
-  f2 = new TF1("f2","1",0,TMath::Pi()*2.);
+  decaynum = 0;
+  phi_old = 0;
+
   f3 = new TF1("f3","1+1/8*pow(TMath::Cos(x),2)+1/24*pow(TMath::Cos(x),4)",0,2*TMath::Pi());//Co60
 
 }
@@ -59,6 +52,7 @@ PrimaryGeneratorAction::PrimaryGeneratorAction(CascadeGenerator *aCasGen) {
 
 PrimaryGeneratorAction::~PrimaryGeneratorAction() {
   delete particleGun;
+  delete f3;
 }
 
 //------------------------------------------------------------------------
@@ -74,8 +68,8 @@ void PrimaryGeneratorAction::GammaDecay(G4Event* anEvent) {
 
 //Generates random isotropic direction
 
-  z = f1->GetRandom();//(-1)->(1)
-  phi = f2->GetRandom();// (0)->(2pi)
+  z = 2.*G4UniformRand()-1.;//(-1)->(1)
+  phi = twopi*G4UniformRand();// (0)->(2pi)
 //  if (decaynum==1) phi = phi_old+f3->GetRandom();// (0)->(2pi) 60Co
   x = sqrt(1.-z*z)*cos(phi);
   y = sqrt(1.-z*z)*sin(phi);
@@ -119,7 +113,7 @@ void PrimaryGeneratorAction::BreitWigner() {
 
 void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent) {
 
-  double z = f1->GetRandom();//(-1)->(1)
+  double z = 2.*G4UniformRand()-1.;//(-1)->(1)
   z = z*12.3/2.;//random position along length of target
 
   particleGun->SetParticlePosition(G4ThreeVector(z*cm,0,0*cm));//at random position along length of target  
@@ -131,24 +125,25 @@ void PrimaryGeneratorAction::GeneratePrimaries(G4Event* anEvent) {
 //  particleGun->SetParticleEnergy(0.662*MeV);
 //  GammaDecay(anEvent);
 
-  std::vector<double> cascade = CasGen->GetCascade();
-  std::vector<double>::iterator it;
+  const std::vector<double>& cascade = CasGen->GetCascade(CasGen->GetCascadeIndex(anEvent->GetEventID()));
+  std::vector<double>::const_iterator it;
 
   decaynum=0;
-/*
+
   for (it=cascade.begin(); it!=cascade.end(); it++) {
     particleGun->SetParticleEnergy(*it*MeV);
     GammaDecay(anEvent);
 //     G4cout << decaynum << G4endl;
     decaynum+=1;
   }
-*/
-  for (int ii=0; ii<1; ii++) {
+/*
+  for (int ii=0; ii<1; ii++) {//single gamma test
     particleGun->SetParticleEnergy(10.1*MeV);
     GammaDecay(anEvent);
 //     G4cout << decaynum << G4endl;
     decaynum+=1;
   }
+*/
 
 }
 
@@ -0,0 +1,397 @@
+#include "ResponseFold.hh"
+#include "TFile.h"
+#include "TTree.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+namespace {
+
+  struct Data_Run {
+    Int_t Event;
+    Int_t Run;
+    Float_t cascade[10];
+  };
+
+  const int n_dep = 1500;//Lib_ deposit bins, 0-15 MeV
+  const int n_fold = 2000;//fold grid, 0-20 MeV (Etot_ range)
+  const double w = 0.01;//MeV per bin of both
+  const int n_rank = 10;//E_ sorted energies
+
+  int Bin(double E) {//fold grid bin, under/overflow into the first/last bin
+    if (!(E>0)) return 0;
+    int b = int(E/w);
+    return (b<n_fold) ? b : n_fold-1;
+  }
+
+  double Phi(double z) {
+    return 0.5*erfc(-z/sqrt(2.));
+  }
+
+  int Top(const std::vector<double>& a) {//last non-zero entry
+    int i = a.size()-1;
+    while (i>0 && a[i]==0) i--;
+    return i;
+  }
+
+  void Convolve(std::vector<double>& a, const std::vector<double>& b) {//sums from n_fold on into n_fold
+    std::vector<double> c(a.size(),0.);
+    int top_a = Top(a), top_b = Top(b);
+    for (int i=0; i<=top_a; i++) {
+      if (a[i]==0) continue;
+      for (int j=0; j<=top_b; j++) {
+        c[min(i+j,n_fold)] += a[i]*b[j];
+      }
+    }
+    a.swap(c);
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+ResponseFold::ResponseFold(Digitiser& D) : Digi(D) {
+
+}
+
+//-------------------------------------------------------------------------
+
+ResponseFold::~ResponseFold() {
+
+}
+
+//-------------------------------------------------------------------------
+//the Run tree maps each run to its energy and no. of gammas, Lib_%i holds
+//the deposits by copy number
+
+void ResponseFold::Read(const char* FileName) {
+
+  TFile* f = new TFile(FileName);
+  if (f->IsZombie()) {
+    cerr << "error: cannot read library " << FileName << endl;
+    exit(1);
+  }
+
+  TTree* t_run = (TTree*)f->Get("Run");
+  if (t_run==0) {
+    cerr << "error: " << FileName << " has no Run tree" << endl;
+    exit(1);
+  }
+
+  Data_Run data_run = {};
+  t_run->SetBranchAddress("Run",&data_run);
+
+  int added = 0;
+
+  for (int i=0; i<t_run->GetEntries(); i++) {
+
+    t_run->GetEntry(i);
+
+    if (data_run.cascade[1]>0) {
+      cerr << "error: " << FileName << " run " << data_run.Run << " is not a single gamma" << endl;
+      exit(1);
+    }
+
+    char name[30];
+    sprintf(name,"Lib_%i",data_run.Run);
+    TH2* h = (TH2*)f->Get(name);
+
+    if (h==0 || h->GetNbinsX()!=max_crys || h->GetNbinsY()!=n_dep) {
+      cerr << "error: " << FileName << " has no " << name << " response, not a \"Library\" run?" << endl;
+      exit(1);
+    }
+
+    if (data_run.Event<=0) continue;
+
+    Energy e;
+    e.E = data_run.cascade[0];
+    e.n_event = data_run.Event;
+    e.count.assign(max_crys*n_dep,0.);
+
+    for (int n=0; n<max_crys; n++) {
+      for (int b=0; b<n_dep; b++) {
+        e.count[n*n_dep+b] = h->GetBinContent(n+1,b+1);
+      }
+      e.count[n*n_dep+n_dep-1] += h->GetBinContent(n+1,n_dep+1);//overflow
+    }
+
+    added += 1;
+
+    int k = std::lower_bound(E_grid.begin(),E_grid.end(),e.E)-E_grid.begin();
+
+    if (k<E_grid.size() && E_grid[k]==e.E) {//same energy again: add up
+      grid[k].n_event += e.n_event;
+      for (int j=0; j<e.count.size(); j++) {
+        grid[k].count[j] += e.count[j];
+      }
+      continue;
+    }
+
+    E_grid.insert(E_grid.begin()+k,e.E);
+    grid.insert(grid.begin()+k,e);
+
+  }
+
+  delete f;
+
+  cout << FileName << ": " << added << " library energies, " << grid.size() << " in response" << endl;
+
+}
+
+//-------------------------------------------------------------------------
+//gammas between grid energies mix the two neighbouring energies with
+//linear weights, deposits scaled to E (as EventPool)
+
+void ResponseFold::Gamma(double E, std::vector<double>& p) {
+
+  const int m = n_fold+1;
+
+  p.assign(max_crys*m,0.);
+
+  int i = std::lower_bound(E_grid.begin(),E_grid.end(),E)-E_grid.begin();
+
+  if (i==E_grid.size() || (E_grid[i]>E && i==0)) {
+    cerr << "error: " << E << " MeV is outside the library grid " << E_grid.front() << "-" << E_grid.back() << " MeV" << endl;
+    exit(1);
+  }
+
+  int lo = i, hi = i;
+  double w_hi = 1;
+  if (E_grid[i]>E) {
+    lo = i-1;
+    w_hi = (E-E_grid[lo])/(E_grid[hi]-E_grid[lo]);
+  }
+
+  for (int g=lo; g<=hi; g++) {
+
+    double weight = (g==hi) ? w_hi : 1-w_hi;
+    if (weight==0) continue;
+
+    const Energy& e = grid[g];
+    double scale = E/e.E;
+
+    for (int n=0; n<max_crys; n++) {
+      double hit = 0;
+      for (int b=0; b<n_dep; b++) {
+        double c = e.count[n*n_dep+b];
+        if (c==0) continue;
+        hit += c;
+        p[n*m+1+Bin((b+0.5)*w*scale)] += weight*c/e.n_event;
+      }
+      p[n*m] += weight*(1-hit/e.n_event);
+    }
+
+  }
+
+}
+
+//-------------------------------------------------------------------------
+//dep: not hit, then deposit bins; out: n_fold bins of the energy the
+//crystal reports (Digitiser::Digitise), missing mass = does not fire
+
+void ResponseFold::Response(int n, const double* dep, double* out) {
+
+  std::fill(out,out+n_fold,0.);
+
+  double gain, offset, sigma, thres;
+  if (Digi.GetCrystal(n,gain,offset,sigma,thres) == false) return;//never fires
+
+  for (int i=1; i<=n_fold; i++) {
+
+    if (dep[i]==0) continue;
+
+    double x = (i-0.5)*w;
+    double mean = gain*x+offset;
+    double sd = fabs(gain)*sigma*sqrt(x);
+
+    if (sd==0) {//Conv off
+      double E = (mean<0) ? 0 : mean;
+      if (thres>0 && E<thres) continue;
+      out[Bin(E)] += dep[i];
+      continue;
+    }
+
+    int k0 = Bin(mean-5*sd);
+    int k1 = Bin(mean+5*sd);
+
+    for (int k=k0; k<=k1; k++) {
+      double a = (k==0 && thres<=0) ? -1.e30 : k*w;//at or below 0 kept as 0
+      double b = (k==n_fold-1) ? 1.e30 : (k+1)*w;
+      if (thres>0 && a<thres) a = thres;
+      if (b<=a) continue;
+      out[k] += dep[i]*(Phi((b-mean)/sd)-Phi((a-mean)/sd));
+    }
+
+  }
+
+}
+
+//-------------------------------------------------------------------------
+//fills h_E, h_Etot and h_mult as DAQManager does for N_events of the
+//cascade, with the expected counts
+
+double ResponseFold::Fold(const std::vector<double>& cascade, double N_events, TH2F* h_E, TH1F* h_Etot, TH1F* h_mult) {
+
+  const int m = n_fold+1;
+
+  std::vector<double> dep(max_crys*m,0.), g, a(m), next(m);
+  for (int n=0; n<max_crys; n++) dep[n*m] = 1;//nothing deposited yet
+
+  for (int j=0; j<cascade.size(); j++) {//deposits add crystal by crystal
+
+    Gamma(cascade[j],g);
+
+    for (int n=0; n<max_crys; n++) {
+
+      std::copy(dep.begin()+n*m,dep.begin()+(n+1)*m,a.begin());
+      const double* b = &g[n*m];
+      int top_a = Top(a);
+      int top_b = m-1;
+      while (top_b>0 && b[top_b]==0) top_b--;
+
+      std::fill(next.begin(),next.end(),0.);
+      next[0] = a[0]*b[0];
+      for (int i=1; i<=top_a; i++) next[i] += a[i]*b[0];
+      for (int k=1; k<=top_b; k++) next[k] += a[0]*b[k];
+
+      for (int i=1; i<=top_a; i++) {
+        if (a[i]==0) continue;
+        for (int k=1; k<=top_b; k++) {//centres of bins i-1 and k-1 add up to the edge of bins i+k-2 and i+k-1
+          double c = 0.5*a[i]*b[k];
+          next[min(i+k-1,n_fold)] += c;
+          next[min(i+k,n_fold)] += c;
+        }
+      }
+
+      std::copy(next.begin(),next.end(),dep.begin()+n*m);
+
+    }
+
+  }
+
+  int b_T = int(floor(Digi.GetTrigger()/w-0.5))+1;//first bin with its centre above E0_threshold
+  if (b_T<0) b_T = 0;
+  if (b_T>n_fold) b_T = n_fold;
+
+  std::vector<double> f(max_crys*n_fold);
+  std::vector<double> tail(max_crys*m,0.);//crystal fires in bin b or above
+  double P[max_crys], H[max_crys];//fires, fires above E0_threshold
+
+  for (int n=0; n<max_crys; n++) {
+    Response(n,&dep[n*m],&f[n*n_fold]);
+    for (int b=n_fold-1; b>=0; b--) {
+      tail[n*m+b] = tail[n*m+b+1]+f[n*n_fold+b];
+    }
+    P[n] = tail[n*m];
+    H[n] = tail[n*m+b_T];
+  }
+
+  //multiplicity: crystals fired, with and without one above E0_threshold
+
+  double mult[max_crys+1][2] = {};
+  mult[0][0] = 1;
+
+  for (int n=0; n<max_crys; n++) {
+    for (int k=n; k>=0; k--) {
+      for (int h=1; h>=0; h--) {
+        double p = mult[k][h];
+        if (p==0) continue;
+        mult[k][h] = p*(1-P[n]);
+        mult[k+1][h] += p*(P[n]-H[n]);
+        mult[k+1][1] += p*H[n];
+      }
+    }
+  }
+
+  double eff = 0, hits = 0;
+
+  for (int k=1; k<=max_crys; k++) {
+    h_mult->Fill(k-1,N_events*mult[k][1]);
+    eff += mult[k][1];
+    hits += k*mult[k][1];
+  }
+
+  //Etot: all events less those without a crystal above E0_threshold.
+  //Crystals are points at multiples of w, bin k split over its edges
+
+  std::vector<double> all(m,0.), low(m,0.), e(m), e_low(m);
+  all[0] = 1;
+  low[0] = 1;
+
+  for (int n=0; n<max_crys; n++) {
+    std::fill(e.begin(),e.end(),0.);
+    std::fill(e_low.begin(),e_low.end(),0.);
+    e[0] = 1-P[n];
+    e_low[0] = 1-P[n];
+    for (int k=0; k<n_fold; k++) {
+      double c = 0.5*f[n*n_fold+k];
+      e[k] += c;
+      e[k+1] += c;
+      if (k<b_T) {
+        e_low[k] += c;
+        e_low[k+1] += c;
+      }
+    }
+    Convolve(all,e);
+    Convolve(low,e_low);
+  }
+
+  for (int k=0; k<m; k++) {
+    double c = all[k]-low[k];
+    if (c>0) h_Etot->Fill((k+0.5)*w,N_events*c);//same bin as k*w, edges to the upper bin as TH1
+  }
+
+  //sorted energies: E_sort[r] is in bin b or above when more than r
+  //crystals are, less the cases without a crystal above E0_threshold
+
+  std::vector<double> J(m*n_rank,0.);//J at n_fold = 0
+
+  for (int b=0; b<n_fold; b++) {
+
+    double A[n_rank+1] = {1};//crystals in bin b or above, the last = n_rank or more
+    double B[n_rank+1] = {1};//the same, none above E0_threshold
+
+    for (int n=0; n<max_crys; n++) {
+
+      double t = tail[n*m+b];
+      double s = (b<b_T) ? t-tail[n*m+b_T] : 0;
+
+      A[n_rank] += A[n_rank-1]*t;
+      B[n_rank] = B[n_rank]*(1-t+s)+B[n_rank-1]*s;
+      for (int k=n_rank-1; k>0; k--) {
+        A[k] = A[k]*(1-t)+A[k-1]*t;
+        B[k] = B[k]*(1-t)+B[k-1]*s;
+      }
+      A[0] *= 1-t;
+      B[0] *= 1-t;
+
+    }
+
+    double sum_A = 0, sum_B = 0;
+
+    for (int r=n_rank-1; r>=0; r--) {
+      sum_A += A[r+1];
+      sum_B += B[r+1];
+      J[b*n_rank+r] = sum_A-((b<b_T) ? sum_B : 0);
+    }
+
+  }
+
+  for (int b=0; b<n_fold; b++) {
+    for (int r=0; r<n_rank; r++) {
+      double c = J[b*n_rank+r]-J[(b+1)*n_rank+r];
+      if (c>0) h_E->Fill((b+0.5)*w,r,N_events*c);
+    }
+  }
+
+  h_mult->SetEntries(N_events*eff);//the coincidences, as analysis.C reads them
+  h_Etot->SetEntries(N_events*eff);
+  h_E->SetEntries(N_events*hits);
+
+  return eff;
+
+}
@@ -26,12 +26,12 @@ RunAction::~RunAction() {
 
 void RunAction::BeginOfRunAction(const G4Run* aRun) {
 
-  DAQMgr->StartOfRun();
-
 //  G4cout << "\n--------------------Run " << aRun->GetRunID() << " start.------------------------------\n" << G4endl;
 
 //  CasGen->SetRun(aRun->GetRunID());//starts at 0
-  CasGen->SetCascade();
+  if (IsMaster()) CasGen->SetCascade();//shared cascade(s), workers only read them
+
+  DAQMgr->StartOfRun();//books one set of histograms per cascade
   //inform the runManager to save random number seed
   G4RunManager::GetRunManager()->SetRandomNumberStore(true);
     
@@ -39,8 +39,8 @@ void RunAction::BeginOfRunAction(const G4Run* aRun) {
 
 void RunAction::EndOfRunAction(const G4Run* aRun) {
 
-  CasGen->EndOfRun();
-  DAQMgr->EndOfRun();
+  if (IsMaster()) CasGen->EndOfRun();
+  DAQMgr->EndOfRun();//workers merge into the master, which then writes
 
   G4int NbOfEvents = aRun->GetNumberOfEvent();
   if (NbOfEvents == 0) return;
@@ -0,0 +1,129 @@
+#include "SparseMatrix.hh"
+#include <algorithm>
+
+//-------------------------------------------------------------------------
+
+SparseMatrix::SparseMatrix() {
+
+}
+
+SparseMatrix::~SparseMatrix() {
+
+}
+
+//-------------------------------------------------------------------------
+
+int SparseMatrix::Bin(double E) {
+
+  if (!(E>=0 && E<sparse_max)) return -1;
+
+  int b = int(E/sparse_max*sparse_bins);
+  return (b<sparse_bins) ? b : sparse_bins-1;
+
+}
+
+//-------------------------------------------------------------------------
+//sorts the pending keys, counts repeats and merges them into keys/counts
+
+void SparseMatrix::Flush() {
+
+  if (pending.size() == 0) return;
+
+  std::sort(pending.begin(),pending.end());
+
+  std::vector<UInt_t> k, c;
+  k.reserve(keys.size()+pending.size());
+  c.reserve(keys.size()+pending.size());
+
+  size_t i = 0, j = 0;
+
+  while (i<keys.size() || j<pending.size()) {
+
+    UInt_t key;
+    UInt_t n = 0;
+
+    if (j>=pending.size() || (i<keys.size() && keys[i]<=pending[j])) key = keys[i];
+    else key = pending[j];
+
+    if (i<keys.size() && keys[i] == key) n += counts[i++];
+    while (j<pending.size() && pending[j] == key) {
+      n += 1;
+      j++;
+    }
+
+    k.push_back(key);
+    c.push_back(n);
+
+  }
+
+  keys.swap(k);
+  counts.swap(c);
+  pending.clear();
+
+}
+
+//-------------------------------------------------------------------------
+
+void SparseMatrix::Merge(SparseMatrix& other) {
+
+  other.Flush();
+  Flush();
+
+  std::vector<UInt_t> k, c;
+  k.reserve(keys.size()+other.keys.size());
+  c.reserve(keys.size()+other.keys.size());
+
+  size_t i = 0, j = 0;
+
+  while (i<keys.size() || j<other.keys.size()) {
+    if (j>=other.keys.size() || (i<keys.size() && keys[i]<other.keys[j])) {
+      k.push_back(keys[i]);
+      c.push_back(counts[i++]);
+    }
+    else if (i>=keys.size() || other.keys[j]<keys[i]) {
+      k.push_back(other.keys[j]);
+      c.push_back(other.counts[j++]);
+    }
+    else {
+      k.push_back(keys[i]);
+      c.push_back(counts[i++]+other.counts[j++]);
+    }
+  }
+
+  keys.swap(k);
+  counts.swap(c);
+  other.Clear();
+
+}
+
+//-------------------------------------------------------------------------
+
+void SparseMatrix::Clear() {
+
+  std::vector<UInt_t>().swap(pending);//memory back, the matrix may idle for runs
+  std::vector<UInt_t>().swap(keys);
+  std::vector<UInt_t>().swap(counts);
+
+}
+
+//-------------------------------------------------------------------------
+
+void SparseMatrix::ToCSR(std::vector<Int_t>& row_ptr, std::vector<UShort_t>& col, std::vector<UInt_t>& val) {
+
+  Flush();
+
+  row_ptr.assign(sparse_bins+1,0);
+  col.resize(keys.size());
+  val.resize(keys.size());
+
+  for (size_t i=0; i<keys.size(); i++) {
+    row_ptr[keys[i]/sparse_bins+1] += 1;
+    col[i] = keys[i]%sparse_bins;
+    val[i] = counts[i];
+  }
+
+  for (int r=0; r<sparse_bins; r++) {
+    row_ptr[r+1] += row_ptr[r];
+  }
+
+}
@@ -0,0 +1,207 @@
+#include "SparseTemplates.hh"
+#include "SparseMatrix.hh"
+#include <algorithm>
+#include <cmath>
+
+//-------------------------------------------------------------------------
+
+namespace {
+
+  bool Align(int n, double min, double max, int& f, int& o) {//data axis in template bins
+
+    double width = sparse_max/sparse_bins;
+    double df = (max-min)/n/width, dof = min/width;
+
+    f = int(df+0.5);
+    o = int(floor(dof+0.5));
+
+    return n>0 && f>0 && fabs(df-f)<1.e-6 && fabs(dof-o)<1.e-6 && o>=0;
+
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+SparseTemplates::SparseTemplates(int an_x, double x_min, double x_max, int an_y, double y_min, double y_max) {
+
+  n_x = an_x;
+  n_y = an_y;
+
+  if (!Align(n_x,x_min,x_max,fx,ox) || !Align(n_y,y_min,y_max,fy,oy)) {
+    fx = 0;
+    fy = 0;
+  }
+
+  X_total = 0;
+  lg_total = 0;
+  neyman_data = 0;
+
+}
+
+SparseTemplates::~SparseTemplates() {
+
+}
+
+//-------------------------------------------------------------------------
+
+void SparseTemplates::SetData(const std::vector<double>& dense) {
+
+  data_key.clear();
+  data_val.clear();
+  X_total = 0;
+  lg_total = 0;
+  neyman_data = 0;
+
+  for (int i=0; i<dense.size(); i++) {
+    if (dense[i]<=0) continue;
+    data_key.push_back(i);//x fastest: key = y*n_x+x
+    data_val.push_back(dense[i]);
+    X_total += dense[i];
+    lg_total += lgamma(dense[i]+1.);
+    neyman_data += dense[i]*dense[i]/std::max(dense[i],1.);
+  }
+
+}
+
+//-------------------------------------------------------------------------
+//row = first axis (E0 or the higher gamma), col = second. A bin is kept if
+//its low edge on either axis is at or above that axis' threshold, as the
+//E0 > t0 || E1 > t1 selection
+
+int SparseTemplates::AddCSR(const Int_t* row_ptr, const UShort_t* col, const UInt_t* val, double t0, double t1) {
+
+  tmpl.push_back(Template());
+  Template& T = tmpl.back();
+
+  double width = sparse_max/sparse_bins;
+  std::vector<std::pair<UInt_t,float> > bins;
+
+  for (int r=0; r<sparse_bins; r++) {
+    for (int k=row_ptr[r]; k<row_ptr[r+1]; k++) {
+      int c = col[k];
+      if (r*width<t0-1.e-9 && c*width<t1-1.e-9) continue;
+      if (r<ox || c<oy) continue;
+      int bx = (r-ox)/fx, by = (c-oy)/fy;
+      if (bx>=n_x || by>=n_y) continue;
+      bins.push_back(std::make_pair(UInt_t(by)*n_x+bx,float(val[k])));
+    }
+  }
+
+  std::sort(bins.begin(),bins.end());
+
+  T.V = 0;
+
+  for (size_t i=0; i<bins.size(); i++) {//merge the fine bins of a data bin
+    if (T.key.size() && T.key.back() == bins[i].first) T.v.back() += bins[i].second;
+    else {
+      T.key.push_back(bins[i].first);
+      T.v.push_back(bins[i].second);
+    }
+    T.V += bins[i].second;
+  }
+
+  return tmpl.size()-1;
+
+}
+
+//-------------------------------------------------------------------------
+
+void SparseTemplates::Finalise() {
+
+  dict = data_key;
+
+  for (int t=0; t<tmpl.size(); t++) {
+    dict.insert(dict.end(),tmpl[t].key.begin(),tmpl[t].key.end());
+  }
+
+  std::sort(dict.begin(),dict.end());
+  dict.erase(std::unique(dict.begin(),dict.end()),dict.end());
+
+  std::vector<float> X(dict.size(),0.f);//data in dictionary order
+
+  for (size_t i=0; i<data_key.size(); i++) {
+    X[std::lower_bound(dict.begin(),dict.end(),data_key[i])-dict.begin()] = data_val[i];
+  }
+
+  for (int t=0; t<tmpl.size(); t++) {
+
+    Template& T = tmpl[t];
+    T.pos.resize(T.key.size());
+    T.x.resize(T.key.size());
+
+    size_t p = 0;
+    for (size_t i=0; i<T.key.size(); i++) {//both sorted, one pass
+      while (dict[p]<T.key[i]) p++;
+      T.pos[i] = p;
+      T.x[i] = X[p];
+    }
+
+    std::vector<UInt_t>().swap(T.key);
+
+  }
+
+}
+
+//-------------------------------------------------------------------------
+//N = s v with s = X_total/V
+
+double SparseTemplates::Evaluate(int t, Likelihood::Statistic stat) {
+
+  const Template& T = tmpl[t];
+  int n = T.v.size();
+  const float* v = n ? &T.v[0] : 0;
+  const float* x = n ? &T.x[0] : 0;
+
+  if (T.V<=0) return HUGE_VAL;
+
+  double s = X_total/T.V;
+
+  if (stat == Likelihood::Neyman) {
+    double vv = 0, xv = 0;
+    for (int k=0; k<n; k++) {
+      float m = (x[k]>1.f) ? x[k] : 1.f;
+      vv += v[k]*v[k]/m;
+      xv += x[k]*v[k]/m;
+    }
+    return neyman_data + s*s*vv - 2*s*xv;
+  }
+
+  double covered = 0;//data under the template
+  for (int k=0; k<n; k++) {
+    covered += x[k];
+  }
+  if (covered<X_total*(1-1.e-6)) return HUGE_VAL;//N = 0 under data
+
+  if (stat == Likelihood::Pearson) {
+    double xx = 0;
+    for (int k=0; k<n; k++) {
+      xx += x[k]*x[k]/v[k];
+    }
+    return xx/s - 2*X_total + s*T.V;
+  }
+
+  double xlv = 0;//sum x ln v
+  for (int k=0; k<n; k++) {
+    xlv += x[k]*log(v[k]);
+  }
+
+  double C = 2*(X_total - xlv - X_total*log(s));//2 sum[N - X ln N]
+
+  if (stat == Likelihood::Poisson) return C + 2*lg_total;
+
+  return C;
+
+}
+
+//-------------------------------------------------------------------------
+
+void SparseTemplates::Batch(Likelihood::Statistic s, std::vector<double>& result) {
+
+  result.resize(tmpl.size());
+
+  for (int t=0; t<tmpl.size(); t++) {
+    result[t] = Evaluate(t,s);
+  }
+
+}
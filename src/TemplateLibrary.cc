@@ -0,0 +1,211 @@
+#include "TemplateLibrary.hh"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cstring>
+#include <cstdio>
+#include <iostream>
+#include <algorithm>
+
+namespace {
+
+  const char magic[8] = "BGOLIB1";
+  const int n_bin[4] = {10,200,1500,1500};//binning of Mult_, Etot_ and E_ of DAQManager
+  const float axis_max[4] = {10,20,15,15};
+
+  int64_t Align(int64_t n) {
+    return (n+63)/64*64;
+  }
+
+  bool ByRun(const LibRun& a, const LibRun& b) {
+    return a.run<b.run;
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+TemplateLibrary::TemplateLibrary() {
+
+  map = 0;
+  size = 0;
+  header = 0;
+  index = 0;
+
+}
+
+//-------------------------------------------------------------------------
+
+TemplateLibrary::~TemplateLibrary() {
+
+  Close();
+
+}
+
+//-------------------------------------------------------------------------
+
+bool TemplateLibrary::Open(string FileName) {
+
+  Close();
+
+  int fd = open(FileName.c_str(),O_RDONLY);
+  if (fd<0) {
+    cerr << "error: cannot read " << FileName << endl;
+    return false;
+  }
+
+  struct stat st;
+  fstat(fd,&st);
+  size = st.st_size;
+
+  if (size<sizeof(LibHeader)) {
+    cerr << "error: " << FileName << " is not a template library" << endl;
+    close(fd);
+    return false;
+  }
+
+  map = mmap(0,size,PROT_READ,MAP_SHARED,fd,0);
+  close(fd);//the mapping stays valid
+
+  if (map == MAP_FAILED) {
+    cerr << "error: cannot map " << FileName << endl;
+    map = 0;
+    return false;
+  }
+
+  header = (const LibHeader*)map;
+
+  LibHeader expect;
+  Layout(expect,header->n_run>=0 ? header->n_run : 0);
+
+  if (memcmp(header->magic,magic,8) != 0 || header->n_run<0
+      || memcmp(header->n_bin,expect.n_bin,sizeof(expect.n_bin)) != 0
+      || header->index != expect.index || header->data != expect.data || header->record != expect.record
+      || size<header->data+header->n_run*header->record) {
+    cerr << "error: " << FileName << " is not a template library or is truncated" << endl;
+    Close();
+    return false;
+  }
+
+  index = (const LibRun*)((const char*)map+header->index);
+
+  return true;
+
+}
+
+//-------------------------------------------------------------------------
+
+void TemplateLibrary::Close() {
+
+  if (map) munmap(map,size);
+
+  map = 0;
+  size = 0;
+  header = 0;
+  index = 0;
+
+}
+
+//-------------------------------------------------------------------------
+
+int TemplateLibrary::Find(int run) const {
+
+  LibRun key;
+  key.run = run;
+
+  const LibRun* it = std::lower_bound(index,index+header->n_run,key,ByRun);
+
+  if (it == index+header->n_run || it->run != run) return -1;
+
+  return it-index;
+
+}
+
+//-------------------------------------------------------------------------
+
+const float* TemplateLibrary::Get(int i, Spectrum s) const {
+
+  const char* p = (const char*)map+header->data+i*header->record;
+
+  for (int k=0; k<s; k++) {
+    p += Align(header->n_bin[k]*sizeof(float));
+  }
+
+  return (const float*)p;
+
+}
+
+//-------------------------------------------------------------------------
+
+void TemplateLibrary::Layout(LibHeader& h, int n_run) {
+
+  memset(&h,0,sizeof(h));
+  memcpy(h.magic,magic,8);
+
+  h.n_run = n_run;
+  h.record = 0;
+
+  for (int k=0; k<4; k++) {
+    h.n_bin[k] = n_bin[k];
+    h.max[k] = axis_max[k];
+    h.record += Align(n_bin[k]*sizeof(float));
+  }
+
+  h.index = Align(sizeof(LibHeader));
+  h.data = h.index+Align(n_run*sizeof(LibRun));
+
+}
+
+//-------------------------------------------------------------------------
+//records are written in run order whatever the order of runs
+
+bool TemplateLibrary::Write(string FileName, const std::vector<LibRun>& runs, const std::vector<float>& spectra) {
+
+  LibHeader h;
+  Layout(h,runs.size());
+
+  int floats = 0;//per record
+  for (int k=0; k<4; k++) floats += h.n_bin[k];
+
+  if (spectra.size() != runs.size()*floats) {
+    cerr << "error: " << spectra.size() << " spectrum bins for " << runs.size() << " runs" << endl;
+    return false;
+  }
+
+  std::vector<int> order(runs.size());
+  for (int i=0; i<order.size(); i++) order[i] = i;
+  std::sort(order.begin(),order.end(),[&runs](int a, int b) {return runs[a].run<runs[b].run;});
+
+  std::vector<char> buffer(h.data+runs.size()*h.record,0);//zero padded
+  memcpy(&buffer[0],&h,sizeof(h));
+
+  for (int i=0; i<order.size(); i++) {
+
+    memcpy(&buffer[h.index+i*sizeof(LibRun)],&runs[order[i]],sizeof(LibRun));
+
+    const float* in = &spectra[order[i]*floats];
+    char* out = &buffer[h.data+i*h.record];
+
+    for (int k=0; k<4; k++) {
+      memcpy(out,in,h.n_bin[k]*sizeof(float));
+      in += h.n_bin[k];
+      out += Align(h.n_bin[k]*sizeof(float));
+    }
+
+  }
+
+  FILE* f = fopen(FileName.c_str(),"wb");
+  if (f == 0) {
+    cerr << "error: cannot write " << FileName << endl;
+    return false;
+  }
+
+  bool ok = fwrite(&buffer[0],buffer.size(),1,f) == 1;
+  ok = (fclose(f) == 0) && ok;
+
+  if (ok == false) cerr << "error: cannot write " << FileName << endl;
+
+  return ok;
+
+}
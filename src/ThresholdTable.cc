@@ -0,0 +1,103 @@
+#include "ThresholdTable.hh"
+#include <cmath>
+
+//-------------------------------------------------------------------------
+
+ThresholdTable::ThresholdTable(TH2* E0Mult, TH2* E0E1, double aN_event) {
+
+  N_event = aN_event;
+
+  n0 = E0Mult->GetNbinsX();
+  n_mult = E0Mult->GetNbinsY()+2;
+  min0 = E0Mult->GetXaxis()->GetXmin();
+  width0 = (E0Mult->GetXaxis()->GetXmax()-min0)/n0;
+
+  above.assign((n0+2)*n_mult,0.);
+
+  for (int b=n0+1; b>=0; b--) {//suffix sums over E0, ROOT bins 0...n0+1
+    for (int m=0; m<n_mult; m++) {
+      double next = (b<n0+1) ? above[(b+1)*n_mult+m] : 0.;
+      above[b*n_mult+m] = next + E0Mult->GetBinContent(b,m);
+    }
+  }
+
+  m0 = E0E1->GetNbinsX()+2;
+  m1 = E0E1->GetNbinsY()+2;
+  min01 = E0E1->GetXaxis()->GetXmin();
+  width01 = (E0E1->GetXaxis()->GetXmax()-min01)/E0E1->GetNbinsX();
+  min1 = E0E1->GetYaxis()->GetXmin();
+  width1 = (E0E1->GetYaxis()->GetXmax()-min1)/E0E1->GetNbinsY();
+
+  below.assign((m0+1)*(m1+1),0.);
+
+  for (int a=1; a<=m0; a++) {//summed area table over ROOT bins 0...m-1
+    for (int b=1; b<=m1; b++) {
+      below[a*(m1+1)+b] = E0E1->GetBinContent(a-1,b-1)
+                        + below[(a-1)*(m1+1)+b] + below[a*(m1+1)+b-1] - below[(a-1)*(m1+1)+b-1];
+    }
+  }
+
+}
+
+//-------------------------------------------------------------------------
+
+ThresholdTable::~ThresholdTable() {
+
+}
+
+//-------------------------------------------------------------------------
+//ROOT bin number of the first bin with lower edge >= t
+
+int ThresholdTable::Edge(double t, double min, double width, int n) {
+
+  if (t<min) return 0;//everything, underflow included
+
+  int b = 1+int(ceil((t-min)/width-1.e-9));
+  if (b>n+1) b = n+1;//overflow only
+
+  return b;
+
+}
+
+//-------------------------------------------------------------------------
+
+double ThresholdTable::Efficiency(double t0) {
+
+  int b = Edge(t0,min0,width0,n0);
+  double sum = 0;
+
+  for (int m=0; m<n_mult; m++) {
+    sum += above[b*n_mult+m];
+  }
+
+  return sum/N_event;
+
+}
+
+//-------------------------------------------------------------------------
+
+void ThresholdTable::Multiplicity(double t0, std::vector<double>& mult) {
+
+  int b = Edge(t0,min0,width0,n0);
+
+  mult.assign(n_mult-3,0.);
+
+  for (int k=0; k<n_mult-3; k++) {//Mult k+1 is in ROOT bin k+2
+    mult[k] = above[b*n_mult+k+2];
+  }
+
+}
+
+//-------------------------------------------------------------------------
+//E0 > t0 || E1 > t1 = all - (E0 <= t0 && E1 <= t1)
+
+double ThresholdTable::Fraction(double t0, double t1) {
+
+  int a = Edge(t0,min01,width01,m0-2);
+  int b = Edge(t1,min1,width1,m1-2);
+
+  double all = below[m0*(m1+1)+m1];
+
+  return (all-below[a*(m1+1)+b])/N_event;
+
+}
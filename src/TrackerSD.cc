@@ -7,14 +7,6 @@ using std::cout;
 using std::cin;
 using std::endl;
 
-namespace {
-
-G4double BGO_temp[31];
-
-G4double BGO_x[31];
-
-}
-
 //--------------------------------------------------------------------------------
 
 TrackerSD::TrackerSD(G4String name, DAQManager* aDAQMgr, InputManager* aInMgr):G4VSensitiveDetector(name) {
@@ -24,13 +16,12 @@ TrackerSD::TrackerSD(G4String name, DAQManager* aDAQMgr, InputManager* aInMgr):G
   DAQMgr = aDAQMgr;
   InMgr = aInMgr;
 
-  for (int i=0; i<Emax; i++){
-
-    if (i<=31) {
-      BGO_temp[i] = 0;
-    }
+  for (int i=0; i<31; i++) {
+    E_crys[i] = 0;
+    BGO_x[i] = 0;
+  }
 
-  }        
+  HCID = -1;
 
   HCname=name;
   collectionName.insert(name);
@@ -82,7 +73,6 @@ TrackerSD::~TrackerSD() {
 void TrackerSD::Initialize(G4HCofThisEvent* HCE) {
 
   trackerCollection = new TrackerHitsCollection(SensitiveDetectorName,collectionName[0]); 
-  static G4int HCID = -1;
   if (HCID<0) {
     HCID = G4SDManager::GetSDMpointer()->GetCollectionID(collectionName[0]);
   }
@@ -112,7 +102,7 @@ G4bool TrackerSD::ProcessHits(G4Step* aStep,G4TouchableHistory*) {
   location = aStep->GetPostStepPoint()->GetPosition();    
 
   copynum = aStep->GetPreStepPoint()->GetTouchableHandle()->GetCopyNumber(1);
-  BGO_temp[copynum] += edep;
+  E_crys[copynum] += edep;
 
   return true;
 
@@ -130,36 +120,19 @@ void TrackerSD::EndOfEvent(G4HCofThisEvent*) {
 
       for (G4int n=0; n<31; n++) {
 
-        double Etot = BGO_temp[n];
+        double Etot = E_crys[n];
 
         Etot /= MeV;//convert to MeV
 //        if (Etot>10) cout <<"!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!" << endl;
         if (Etot>0) {
 
-          double factor = sqrt(8.0*log(2.0));
-          double k = 0.1733;
-          double pi = 3.14159265;
-          double sigma = 1.*(k*sqrt(Etot))/factor*0.7;
-
-          bool Conv;
-          InMgr->GetVariable("Conv",Conv);
-
-          if (Conv==true) {
-            double Etot_new = gRandom->Gaus(Etot,sigma);
-//          double Etot_new = TrackerSD::Gaus(Etot,sigma);
-            if (Etot_new>0.) {
-              Etot = Etot_new;
-            }
-            else {
-              Etot = 0.;
-            }
-          }
+          //unsmeared, resolution is applied by the DAQManager's Digitiser
 
 //          G4cout << "Hit in " << pos << " " << n << " depositing " << Etot << " MeV " << G4endl;//verbosity = high
           DAQMgr->SetGammaE(Etot);
           DAQMgr->SetDetNum(n);
         }
-        BGO_temp[n] = 0;
+        E_crys[n] = 0;
       }
 
 //    }